@@ -0,0 +1,49 @@
+/*
+ * ResultTrampoline.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_CYTHON_RESULT_TRAMPOLINE_H
+#define _OPENCOG_CYTHON_RESULT_TRAMPOLINE_H
+
+#include <opencog/ure/forwardchainer/ForwardChainer.h>
+
+namespace opencog {
+
+// C function calling a Python callable, passed as opaque data, over
+// a product. Cython cannot turn a Python callable into a
+// std::function, so it passes such function instead.
+typedef bool (*ResultTrampoline)(void* callable, const Handle& product);
+
+/**
+ * Subscribe trampoline(callable, product) to the products of fc. The
+ * caller must keep callable alive as long as fc may call it.
+ */
+inline void subscribe_trampoline(ForwardChainer& fc,
+                                 ResultTrampoline trampoline,
+                                 void* callable)
+{
+	fc.subscribe([trampoline, callable](const Handle& product) {
+			return trampoline(callable, product);
+		});
+}
+
+} // ~namespace opencog
+
+#endif // _OPENCOG_CYTHON_RESULT_TRAMPOLINE_H
@@ -1,17 +1,30 @@
 from opencog.atomspace import types
 from cython.operator cimport dereference as deref, preincrement as inc
 from opencog.atomspace cimport cHandle, Atom, AtomSpace, TruthValue
-from ure cimport cForwardChainer
+from ure cimport cForwardChainer, subscribe_trampoline
+import traceback
 
 # Create a Cython extension type which holds a C++ instance
 # as an attribute and create a bunch of forwarding methods
 # Python extension type.
 
 
+cdef bint result_trampoline(void* callable, const cHandle& product) noexcept with gil:
+    # Call the subscribed Python callable over the product. As
+    # exceptions cannot go through the chainer, print them and cancel
+    # the chaining.
+    try:
+        return bool((<object>callable)(Atom.createAtom(product)))
+    except BaseException:
+        traceback.print_exc()
+        return False
+
+
 cdef class ForwardChainer:
     cdef cForwardChainer * chainer
     cdef AtomSpace _as
     cdef AtomSpace _trace_as
+    cdef list _subscribers
     def __cinit__(self, AtomSpace _as,
                   Atom rbs,
                   Atom source,
@@ -38,15 +51,57 @@ cdef class ForwardChainer:
                                         handle_vector)
         self._as = _as
         self._trace_as = trace_as
+        self._subscribers = []
 
     def do_chain(self):
-        return self.chainer.do_chain()
+        # Release the GIL, so that the subscribed callables may be
+        # called from the workers of the chainer
+        with nogil:
+            self.chainer.do_chain()
 
     def get_results(self):
         cdef cHandle res_handle = self.chainer.get_results()
         cdef Atom result = Atom.createAtom(res_handle)
         return result
 
+    def get_results_size(self):
+        return self.chainer.get_results_size()
+
+    def get_results_list(self, start=0):
+        """
+        Return the distinct results from the start-th one, in order of
+        inference, as a list rather than a SetLink in the atomspace.
+        """
+        cdef vector[cHandle] res = self.chainer.get_results_seq(start)
+        return [Atom.createAtom(h) for h in res]
+
+    def subscribe(self, callback):
+        """
+        Call callback over each new product as soon as it is inferred.
+        callback is either a Python callable, taking the product as an
+        Atom, or an Atom, typically a GroundedPredicateNode, evaluated
+        over the product wrapped in a ListLink. The chaining is
+        cancelled if the callable returns a false value or raises an
+        exception, or if the predicate evaluates to a TV with a mean
+        below 0.5.
+
+        Callables may be called from the workers of the chainer, with
+        the GIL held.
+        """
+        if isinstance(callback, Atom):
+            self.chainer.subscribe(deref((<Atom>callback).handle))
+        else:
+            # Keep the callable alive as long as the chainer
+            self._subscribers.append(callback)
+            subscribe_trampoline(deref(self.chainer), result_trampoline,
+                                 <void*>callback)
+
+    def cancel(self):
+        self.chainer.cancel()
+
+    def is_cancelled(self):
+        return self.chainer.is_cancelled()
+
     def __dealloc__(self):
         del self.chainer
         self._trace_as = None
@@ -13,8 +13,20 @@ cdef extern from "opencog/ure/forwardchainer/ForwardChainer.h" namespace "openco
                         cAtomSpace* trace_as,
                         const vector[cHandle]& focus_set) except +
 
-        void do_chain() except +
+        void do_chain() nogil except +
         cHandle get_results() const
+        size_t get_results_size() const
+        vector[cHandle] get_results_seq(size_t) const
+        void subscribe(const cHandle& predicate)
+        void cancel()
+        bint is_cancelled() const
+
+
+cdef extern from "ResultTrampoline.h" namespace "opencog":
+    ctypedef bint (*ResultTrampoline)(void* callable, const cHandle& product) noexcept
+    void subscribe_trampoline(cForwardChainer& fc,
+                              ResultTrampoline trampoline,
+                              void* callable)
 
 
 cdef extern from "opencog/ure/backwardchainer/Fitness.h" namespace "opencog::BITNodeFitness":
@@ -24,8 +24,16 @@
 ;; -- ure-set-maximum-iterations -- Set the URE:maximum-iterations parameter
 ;; -- ure-set-complexity-penalty -- Set the URE:complexity-penalty parameter
 ;; -- ure-set-jobs -- Set the URE:jobs parameter
+;; -- ure-set-maximum-time -- Set the URE:maximum-time parameter
+;; -- ure-set-maximum-kb-additions -- Set the URE:maximum-kb-additions parameter
+;; -- ure-set-maximum-population-size -- Set the URE:maximum-population-size parameter
+;; -- ure-set-random-seed -- Set the URE:random-seed parameter
 ;; -- ure-set-fc-retry-exhausted-sources -- Set the URE:FC:retry-exhausted-sources parameter
 ;; -- ure-set-fc-full-rule-application -- Set the URE:FC:full-rule-application parameter
+;; -- ure-set-fc-semi-naive-rule-application -- Set the URE:FC:semi-naive-rule-application parameter
+;; -- ure-set-fc-maximum-source-set-size -- Set the URE:FC:maximum-source-set-size parameter
+;; -- ure-set-fc-batch-size -- Set the URE:FC:batch-size parameter
+;; -- ure-set-fc-deterministic -- Set the URE:FC:deterministic parameter
 ;; -- ure-set-bc-maximum-bit-size -- Set the URE:BC:maximum-bit-size
 ;; -- ure-set-bc-mm-complexity-penalty -- Set the URE:BC:MM:complexity-penalty
 ;; -- ure-set-bc-mm-compressiveness -- Set the URE:BC:MM:compressiveness
@@ -84,12 +92,18 @@
                  (vardecl (List))
                  (trace-as #f)
                  (focus-set (Set))
+                 (subscriber (List))
                  (attention-allocation *unspecified*)
                  (maximum-iterations *unspecified*)
                  (complexity-penalty *unspecified*)
                  (jobs *unspecified*)
+                 (random-seed *unspecified*)
                  (fc-retry-exhausted-sources *unspecified*)
-                 (fc-full-rule-application *unspecified*))
+                 (fc-full-rule-application *unspecified*)
+                 (fc-semi-naive-rule-application *unspecified*)
+                 (fc-maximum-source-set-size *unspecified*)
+                 (fc-batch-size *unspecified*)
+                 (fc-deterministic *unspecified*))
 "
   Forward Chainer call.
 
@@ -97,12 +111,18 @@
                  #:vardecl vd
                  #:trace-as tas
                  #:focus-set fs
+                 #:subscriber sub
                  #:attention-allocation aa
                  #:maximum-iterations mi
                  #:complexity-penalty cp
                  #:jobs jb
+                 #:random-seed rs
                  #:fc-retry-exhausted-sources res
-                 #:fc-full-rule-application fra)
+                 #:fc-full-rule-application fra
+                 #:fc-semi-naive-rule-application snra
+                 #:fc-maximum-source-set-size mss
+                 #:fc-batch-size bs
+                 #:fc-deterministic det)
 
   rbs: ConceptNode representing a rulebase.
 
@@ -117,6 +137,14 @@
   fs: [optional] Focus set, a SetLink with all atoms to consider for
       forward chaining.
 
+  sub: [optional] Predicate, typically a GroundedPredicateNode, called
+       on each new product as soon as it is inferred, wrapped in a
+       ListLink. If it returns a TV with a mean below 0.5 the forward
+       chainer is cancelled. For instance
+
+       (define (on-product p) (display p) (stv 1 1))
+       (cog-fc rbs source #:subscriber (GroundedPredicate "scm: on-product"))
+
   aa: [optional, default=#f] Whether the atoms involved with the
       inference are restricted to the attentional focus.
 
@@ -133,6 +161,10 @@
       for the forward chainer as the output of a rule application may depend
       on the output of other rules.
 
+  rs: [optional, default=-1] Random seed. If non-negative, the chainer
+      and each of its jobs draw from their own random streams derived
+      from it. Negative means using the global random generator.
+
   res: [optional, default=#f] Whether exhausted sources should be
        retried. A source is exhausted if all its valid rules (so that at
        least one rule premise unifies with the source) have been applied to
@@ -144,6 +176,25 @@
        entire atomspace, not just the source. This can be convienient if
        the goal is to rapidly achieve inference closure.
 
+  snra: [optional, default=#f] Whether, under full rule application, a
+        rule already applied should only be applied over the atoms
+        produced since its last application (semi-naive evaluation),
+        rather than re-deriving all its previous conclusions.
+
+  mss: [optional, default=-1] Maximum number of sources. Beyond that
+       the least promising sources, exhausted first then of lowest
+       weight, are evicted, except the initial ones. Negative means
+       unlimited.
+
+  bs: [optional, default=1] Number of sources expanded per iteration.
+      Sources with the same selected rule have it applied only once.
+
+  det: [optional, default=#f] Whether, when multi-threaded, the
+       results should only depend on the random seed and the number of
+       jobs. Iterations are then run in rounds, their rules being
+       applied in parallel and their results committed in iteration
+       order.
+
   Note that the defaults of the optional arguments are not determined
   here (although they attempt to be documented here).  That is the case
   in order not to overwrite existing parameters set by
@@ -160,15 +211,26 @@
       (ure-set-complexity-penalty rbs complexity-penalty))
   (if (not (unspecified? jobs))
       (ure-set-jobs rbs jobs))
+  (if (not (unspecified? random-seed))
+      (ure-set-random-seed rbs random-seed))
   (if (not (unspecified? fc-retry-exhausted-sources))
       (ure-set-fc-retry-exhausted-sources rbs fc-retry-exhausted-sources))
   (if (not (unspecified? fc-full-rule-application))
       (ure-set-fc-full-rule-application rbs fc-full-rule-application))
+  (if (not (unspecified? fc-semi-naive-rule-application))
+      (ure-set-fc-semi-naive-rule-application rbs fc-semi-naive-rule-application))
+  (if (not (unspecified? fc-maximum-source-set-size))
+      (ure-set-fc-maximum-source-set-size rbs fc-maximum-source-set-size))
+  (if (not (unspecified? fc-batch-size))
+      (ure-set-fc-batch-size rbs fc-batch-size))
+  (if (not (unspecified? fc-deterministic))
+      (ure-set-fc-deterministic rbs fc-deterministic))
 
   ;; Defined optional atomspaces and call the forward chainer
   (let* ((trace-enabled (cog-atomspace? trace-as))
          (tas (if trace-enabled trace-as (cog-atomspace))))
-    (cog-mandatory-args-fc rbs source vardecl trace-enabled tas focus-set)))
+    (cog-mandatory-args-fc rbs source vardecl trace-enabled tas focus-set
+                           subscriber)))
 
 (define* (cog-bc rbs target
                  #:key
@@ -180,6 +242,7 @@
                  (maximum-iterations *unspecified*)
                  (complexity-penalty *unspecified*)
                  (jobs *unspecified*)
+                 (random-seed *unspecified*)
                  (bc-maximum-bit-size *unspecified*)
                  (bc-mm-complexity-penalty *unspecified*)
                  (bc-mm-compressiveness *unspecified*))
@@ -194,6 +257,7 @@
                  #:attention-allocation aa
                  #:maximum-iterations mi
                  #:complexity-penalty cp
+                 #:random-seed rs
                  #:bc-maximum-bit-size mbs
                  #:bc-mm-complexity-penalty mcp
                  #:bc-mm-compressiveness mc)
@@ -226,7 +290,11 @@
   jb: [optional, default=1] Number of jobs to run in parallel. Can
       speed up reasoning, note that this may alter the results, especially
       for the forward chainer as the output of a rule application may depend
-      on the output of the other rules.
+      on the output of the other rules. The backward chainer expands
+      and fulfills several inference trees in parallel, on jobs workers.
+
+  rs: [optional, default=-1] Random seed. Negative means using the
+      global random generator.
 
   mbs: [optional, default=-1] Maximum size of the inference tree pool
        to evolve. Negative means unlimited.
@@ -254,6 +322,8 @@
       (ure-set-complexity-penalty rbs complexity-penalty))
   (if (not (unspecified? jobs))
       (ure-set-jobs rbs jobs))
+  (if (not (unspecified? random-seed))
+      (ure-set-random-seed rbs random-seed))
   (if (not (unspecified? bc-maximum-bit-size))
       (ure-set-bc-maximum-bit-size rbs bc-maximum-bit-size))
   (if (not (unspecified? bc-mm-complexity-penalty))
@@ -636,7 +706,9 @@
 
 (define (ure-set-jobs rbs value)
 "
-  Set the URE:jobs parameter of a given RBS
+  Set the URE:jobs parameter of a given RBS, the number of jobs to run
+  in parallel. The backward chainer expands and fulfills several of
+  its inference trees in parallel.
 
   ExecutionLink
     SchemaNode \"URE:jobs\"
@@ -647,6 +719,68 @@
 "
   (ure-set-num-parameter rbs "URE:jobs" value))
 
+(define (ure-set-maximum-time rbs value)
+"
+  Set the URE:maximum-time parameter of a given RBS, the maximum
+  wall-clock time of the chaining in seconds. Negative means
+  unlimited.
+
+  ExecutionLink
+    SchemaNode \"URE:maximum-time\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:maximum-time" value))
+
+(define (ure-set-maximum-kb-additions rbs value)
+"
+  Set the URE:maximum-kb-additions parameter of a given RBS, the
+  maximum number of atoms added to the knowledge base during the
+  chaining. Negative means unlimited.
+
+  ExecutionLink
+    SchemaNode \"URE:maximum-kb-additions\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:maximum-kb-additions" value))
+
+(define (ure-set-maximum-population-size rbs value)
+"
+  Set the URE:maximum-population-size parameter of a given RBS, the
+  maximum number of sources of the forward chainer, or and-BITs of
+  the backward chainer, beyond which the chaining terminates.
+  Negative means unlimited.
+
+  ExecutionLink
+    SchemaNode \"URE:maximum-population-size\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:maximum-population-size" value))
+
+(define (ure-set-random-seed rbs value)
+"
+  Set the URE:random-seed parameter of a given RBS, the master seed
+  of the random generators of the chainers. Each job of a
+  multi-threaded chainer draws from its own stream derived from it.
+  Negative means using the global random generator.
+
+  ExecutionLink
+    SchemaNode \"URE:random-seed\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:random-seed" value))
+
 (define (ure-set-fc-retry-exhausted-sources rbs value)
 "
   Set the URE:FC:retry-exhausted-sources parameter of a given RBS
@@ -673,6 +807,67 @@
 "
   (ure-set-fuzzy-bool-parameter rbs "URE:FC:full-rule-application" value))
 
+(define (ure-set-fc-semi-naive-rule-application rbs value)
+"
+  Set the URE:FC:semi-naive-rule-application parameter of a given RBS
+
+  EvaluationLink (stv value 1)
+    PredicateNode \"URE:FC:semi-naive-rule-application\"
+    rbs
+
+  If the provided value is a boolean, then it is automatically
+  converted into tv.
+"
+  (ure-set-fuzzy-bool-parameter rbs "URE:FC:semi-naive-rule-application" value))
+
+(define (ure-set-fc-maximum-source-set-size rbs value)
+"
+  Set the URE:FC:maximum-source-set-size parameter of a given RBS, the
+  maximum number of sources of the forward chainer, beyond which the
+  least promising sources are evicted. Negative means unlimited.
+
+  ExecutionLink
+    SchemaNode \"URE:FC:maximum-source-set-size\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:FC:maximum-source-set-size" value))
+
+(define (ure-set-fc-batch-size rbs value)
+"
+  Set the URE:FC:batch-size parameter of a given RBS, the number of
+  sources the forward chainer expands per iteration. The sources with
+  the same selected rule, up to alpha-conversion, have it applied only
+  once. That mostly happens with URE:FC:full-rule-application, as
+  rules are otherwise specialized to their sources.
+
+  ExecutionLink
+    SchemaNode \"URE:FC:batch-size\"
+    rbs
+    NumberNode value
+
+  Delete any previous one if exists.
+"
+  (ure-set-num-parameter rbs "URE:FC:batch-size" value))
+
+(define (ure-set-fc-deterministic rbs value)
+"
+  Set the URE:FC:deterministic parameter of a given RBS, whether the
+  results of the multi-threaded forward chainer should only depend on
+  the random seed and the number of jobs. The batch size is ignored
+  in that mode.
+
+  EvaluationLink (stv value 1)
+    PredicateNode \"URE:FC:deterministic\"
+    rbs
+
+  If the provided value is a boolean, then it is automatically
+  converted into tv.
+"
+  (ure-set-fuzzy-bool-parameter rbs "URE:FC:deterministic" value))
+
 (define (ure-set-bc-maximum-bit-size rbs value)
 "
   Set the URE:BC:maximum-bit-size parameter of a given RBS
@@ -1094,8 +1289,16 @@
           ure-set-maximum-iterations
           ure-set-complexity-penalty
           ure-set-jobs
+          ure-set-maximum-time
+          ure-set-maximum-kb-additions
+          ure-set-maximum-population-size
+          ure-set-random-seed
           ure-set-fc-retry-exhausted-sources
           ure-set-fc-full-rule-application
+          ure-set-fc-semi-naive-rule-application
+          ure-set-fc-maximum-source-set-size
+          ure-set-fc-batch-size
+          ure-set-fc-deterministic
           ure-set-bc-maximum-bit-size
           ure-set-bc-mm-complexity-penalty
           ure-set-bc-mm-compressiveness
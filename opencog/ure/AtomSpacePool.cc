@@ -0,0 +1,118 @@
+/*
+ * AtomSpacePool.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <functional>
+#include <thread>
+
+#include "AtomSpacePool.h"
+
+using namespace opencog;
+
+AtomSpacePool::Lease::Lease(AtomSpacePool& pool, size_t free_list,
+                            std::unique_ptr<AtomSpace> as)
+	: _pool(&pool), _free_list(free_list), _as(std::move(as)) {}
+
+AtomSpacePool::Lease::Lease(Lease&& other)
+	: _pool(other._pool), _free_list(other._free_list),
+	  _as(std::move(other._as)) {}
+
+AtomSpacePool::Lease::~Lease()
+{
+	if (_as)
+		_pool->give_back(_free_list, std::move(_as));
+}
+
+AtomSpace& AtomSpacePool::Lease::operator*() const
+{
+	return *_as;
+}
+
+AtomSpace* AtomSpacePool::Lease::operator->() const
+{
+	return _as.get();
+}
+
+AtomSpace* AtomSpacePool::Lease::get() const
+{
+	return _as.get();
+}
+
+AtomSpacePool::AtomSpacePool(AtomSpace* parent)
+	: _parent(parent), _allocated(0) {}
+
+AtomSpacePool::Lease AtomSpacePool::borrow()
+{
+	// Borrow from the free list of the calling thread, or else from
+	// the free list of another thread, so that the number of
+	// allocated atomspaces remains bounded by the number of
+	// simultaneous borrowings.
+	size_t own = thread_free_list();
+	for (size_t i = 0; i < free_lists; i++) {
+		std::unique_ptr<AtomSpace> as = pop((own + i) % free_lists);
+		if (as)
+			return Lease(*this, own, std::move(as));
+	}
+
+	// Allocate outside of the locks
+	_allocated++;
+	return Lease(*this, own, std::unique_ptr<AtomSpace>(new AtomSpace(_parent)));
+}
+
+size_t AtomSpacePool::allocated() const
+{
+	return _allocated;
+}
+
+size_t AtomSpacePool::available() const
+{
+	size_t count = 0;
+	for (const FreeList& fl : _free) {
+		std::lock_guard<std::mutex> lock(fl.mutex);
+		count += fl.atomspaces.size();
+	}
+	return count;
+}
+
+void AtomSpacePool::give_back(size_t free_list, std::unique_ptr<AtomSpace> as)
+{
+	// Clear outside of the lock, only the atoms of the scratch
+	// atomspace are removed, not the ones of its parent.
+	as->clear();
+	FreeList& fl = _free[free_list];
+	std::lock_guard<std::mutex> lock(fl.mutex);
+	fl.atomspaces.push_back(std::move(as));
+}
+
+std::unique_ptr<AtomSpace> AtomSpacePool::pop(size_t free_list)
+{
+	FreeList& fl = _free[free_list];
+	std::lock_guard<std::mutex> lock(fl.mutex);
+	if (fl.atomspaces.empty())
+		return nullptr;
+	std::unique_ptr<AtomSpace> as(std::move(fl.atomspaces.back()));
+	fl.atomspaces.pop_back();
+	return as;
+}
+
+size_t AtomSpacePool::thread_free_list()
+{
+	return std::hash<std::thread::id>()(std::this_thread::get_id()) % free_lists;
+}
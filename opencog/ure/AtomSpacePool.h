@@ -0,0 +1,131 @@
+/*
+ * AtomSpacePool.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_ATOMSPACEPOOL_H_
+#define _OPENCOG_URE_ATOMSPACEPOOL_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencog/atomspace/AtomSpace.h>
+
+namespace opencog
+{
+
+/**
+ * Pool of scratch atomspaces, all children of the same parent (or
+ * without parent), to hold intermediary atoms such as rules to
+ * execute, without constructing and destroying an atomspace each
+ * time.
+ *
+ * An atomspace is borrowed for the lifetime of the returned lease,
+ * during which it is used exclusively by its borrower, so that the
+ * pool can be shared between threads. When the lease is destroyed
+ * the atomspace is cleared and given back to the pool.
+ *
+ * Free atomspaces are kept in per-thread free lists, so that the
+ * workers of a chainer do not contend over the pool. Threads are
+ * mapped to free lists by hashing their ids, a thread only borrowing
+ * from the free list of another thread when its own is empty.
+ */
+class AtomSpacePool
+{
+public:
+	/**
+	 * Exclusive access to a borrowed atomspace, given back to the
+	 * pool upon destruction.
+	 */
+	class Lease
+	{
+	public:
+		Lease(AtomSpacePool& pool, size_t free_list,
+		      std::unique_ptr<AtomSpace> as);
+		Lease(Lease&& other);
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		~Lease();
+
+		AtomSpace& operator*() const;
+		AtomSpace* operator->() const;
+		AtomSpace* get() const;
+
+	private:
+		AtomSpacePool* _pool;
+
+		// Free list of the borrowing thread, where the atomspace is
+		// given back
+		size_t _free_list;
+
+		std::unique_ptr<AtomSpace> _as;
+	};
+
+	/**
+	 * Create a pool of atomspaces, children of parent if not null.
+	 */
+	AtomSpacePool(AtomSpace* parent=nullptr);
+
+	/**
+	 * Borrow a cleared atomspace, preferably from the free list of
+	 * the calling thread, allocating a new one if none is available.
+	 */
+	Lease borrow();
+
+	/**
+	 * Number of atomspaces allocated since the creation of the pool,
+	 * that is about the maximum number of atomspaces simultaneously
+	 * borrowed.
+	 */
+	size_t allocated() const;
+
+	/**
+	 * Number of atomspaces currently available.
+	 */
+	size_t available() const;
+
+private:
+	// Clear as and put it back in the given free list
+	void give_back(size_t free_list, std::unique_ptr<AtomSpace> as);
+
+	// Pop an atomspace from the given free list, return null if empty
+	std::unique_ptr<AtomSpace> pop(size_t free_list);
+
+	// Free list of the calling thread
+	static size_t thread_free_list();
+
+	AtomSpace* _parent;
+
+	// Atomspaces not currently borrowed, per thread
+	struct FreeList
+	{
+		std::vector<std::unique_ptr<AtomSpace>> atomspaces;
+		mutable std::mutex mutex;
+	};
+	static const size_t free_lists = 16;
+	std::array<FreeList, free_lists> _free;
+
+	std::atomic<size_t> _allocated;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_ATOMSPACEPOOL_H_ */
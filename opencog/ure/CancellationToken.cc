@@ -0,0 +1,68 @@
+/*
+ * CancellationToken.cc
+ *
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "CancellationToken.h"
+
+#include <limits>
+
+using namespace opencog;
+
+CancellationToken::CancellationToken()
+	: _cancelled(false),
+	  _deadline(std::numeric_limits<Clock::rep>::max()) {}
+
+void CancellationToken::cancel()
+{
+	_cancelled = true;
+}
+
+void CancellationToken::set_deadline(Clock::time_point deadline)
+{
+	_deadline = deadline.time_since_epoch().count();
+}
+
+void CancellationToken::set_timeout(double seconds)
+{
+	set_deadline(Clock::now() +
+	             std::chrono::duration_cast<Clock::duration>(
+		             std::chrono::duration<double>(seconds)));
+}
+
+bool CancellationToken::is_cancelled() const
+{
+	return _cancelled
+		or _deadline <= Clock::now().time_since_epoch().count();
+}
+
+ScopedCancellationToken::ScopedCancellationToken(CancellationTokenPtr& slot,
+                                                 const CancellationTokenPtr& token)
+	: _slot(slot), _installed(token != nullptr)
+{
+	if (_installed)
+		_previous = std::atomic_exchange(&_slot, token);
+}
+
+ScopedCancellationToken::~ScopedCancellationToken()
+{
+	if (_installed)
+		std::atomic_store(&_slot, _previous);
+}
@@ -0,0 +1,101 @@
+/*
+ * CancellationToken.h
+ *
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_CANCELLATIONTOKEN_H_
+#define _OPENCOG_URE_CANCELLATIONTOKEN_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace opencog
+{
+
+/**
+ * Token passed to a chainer to cancel its chaining, either explicitly
+ * from another thread, or once a deadline has passed.
+ *
+ * Cancellation is cooperative. The chainer checks the token between
+ * rule applications, or between expansions and fulfillments for the
+ * backward chainer, as well as on each grounding found by the pattern
+ * matcher while applying a rule. A rule application in progress thus
+ * stops at its next grounding, keeping the conclusions of the
+ * groundings found so far, leaving the chainer in a consistent
+ * state, with the results so far available.
+ */
+class CancellationToken
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	CancellationToken();
+
+	/**
+	 * Cancel, can be called from any thread.
+	 */
+	void cancel();
+
+	/**
+	 * Cancel once the given time point, or the given number of
+	 * seconds from now, has passed.
+	 */
+	void set_deadline(Clock::time_point deadline);
+	void set_timeout(double seconds);
+
+	/**
+	 * Return true iff cancel has been called or the deadline has
+	 * passed.
+	 */
+	bool is_cancelled() const;
+
+private:
+	std::atomic<bool> _cancelled;
+
+	// Deadline, as a number of clock ticks since its epoch, the
+	// maximum value if there is none.
+	std::atomic<Clock::rep> _deadline;
+};
+
+typedef std::shared_ptr<CancellationToken> CancellationTokenPtr;
+
+/**
+ * Install a token in the given slot, typically the token of a
+ * chainer, for the lifetime of this object, then restore the
+ * previous one. The slot is accessed atomically so that it may be
+ * read from other threads meanwhile. A null token leaves the slot
+ * untouched.
+ */
+class ScopedCancellationToken
+{
+public:
+	ScopedCancellationToken(CancellationTokenPtr& slot,
+	                        const CancellationTokenPtr& token);
+	~ScopedCancellationToken();
+
+private:
+	CancellationTokenPtr& _slot;
+	CancellationTokenPtr _previous;
+	bool _installed;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_CANCELLATIONTOKEN_H_ */
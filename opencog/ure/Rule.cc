@@ -23,7 +23,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <queue>
+#include <unordered_set>
 
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -48,23 +50,63 @@ namespace opencog {
 
 void RuleSet::expand_meta_rules(AtomSpace& as)
 {
+	RuleSet new_rules;
+	for (const Rule& rule : *this)
+		if (rule.is_meta())
+			insert_meta_produced(rule, rule.apply(as), new_rules);
+	insert(new_rules.begin(), new_rules.end());
+}
+
+void RuleSet::expand_meta_rules(AtomSpace& as, const HandleSet& new_atoms,
+                                AtomSpacePool& scratch_as_pool)
+{
+	if (new_atoms.empty() or not has_meta_rules())
+		return;
+
+	// Specialized meta rules are added to a scratch child atomspace
+	// before being run, so as not to pollute as.
+	AtomSpacePool::Lease derived_as = scratch_as_pool.borrow();
 	RuleSet new_rules;
 	for (const Rule& rule : *this) {
-		if (rule.is_meta()) {
-			Handle result = rule.apply(as);
-			for (const Handle& produced_h : result->getOutgoingSet()) {
-				Rule produced(rule.get_alias(), produced_h, rule.get_rbs());
-				bool ir = new_rules.insert(produced);
-				if (ir) {
-					ure_logger().debug() << "New rule produced from meta rule:"
-					                     << std::endl << oc_to_string(produced);
-				}
+		if (not rule.is_meta())
+			continue;
+		for (const Handle& h : new_atoms) {
+			RuleTypedSubstitutionMap urm =
+				rule.unify_source(h, Handle::UNDEFINED, &as);
+			for (const Rule& sr : Rule::strip_typed_substitution(urm)) {
+				Handle rh = derived_as->add_atom(sr.get_rule());
+				insert_meta_produced(rule, HandleCast(rh->execute(&as)),
+				                     new_rules);
 			}
 		}
 	}
 	insert(new_rules.begin(), new_rules.end());
 }
 
+bool RuleSet::has_meta_rules() const
+{
+	for (const Rule& rule : *this)
+		if (rule.is_meta())
+			return true;
+	return false;
+}
+
+void RuleSet::insert_meta_produced(const Rule& meta_rule, const Handle& result,
+                                   RuleSet& new_rules)
+{
+	for (const Handle& produced_h : result->getOutgoingSet()) {
+		// Skip rules already produced in previous runs
+		if (not _meta_produced.insert(produced_h).second)
+			continue;
+		Rule produced(meta_rule.get_alias(), produced_h, meta_rule.get_rbs());
+		bool ir = new_rules.insert(produced);
+		if (ir) {
+			ure_logger().debug() << "New rule produced from meta rule:"
+			                     << std::endl << oc_to_string(produced);
+		}
+	}
+}
+
 HandleSet RuleSet::aliases() const
 {
 	HandleSet aliases;
@@ -122,6 +164,8 @@ Rule::Rule(const Rule& r)
 	_rbs = r._rbs;
 	_tv = r._tv;
 	_exhausted = r._exhausted;
+	std::lock_guard<std::mutex> lock(r._mutex);
+	_ns_rules = r._ns_rules;
 }
 
 Rule::Rule(const Handle& rule_alias, const Handle& rbs)
@@ -201,6 +245,9 @@ bool Rule::operator==(const Rule& r) const
 
 Rule& Rule::operator=(const Rule& r)
 {
+	if (this == &r)
+		return *this;
+
 	premises_as_clauses = r.premises_as_clauses;
 	_rule = r._rule;
 	_rule_alias = r._rule_alias;
@@ -208,6 +255,13 @@ Rule& Rule::operator=(const Rule& r)
 	_rbs = r._rbs;
 	_tv = r._tv;
 	_exhausted = r._exhausted;
+	std::vector<std::shared_ptr<const Rule>> ns_rules;
+	{
+		std::lock_guard<std::mutex> lock(r._mutex);
+		ns_rules = r._ns_rules;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	_ns_rules = std::move(ns_rules);
 
 	return *this;
 }
@@ -230,6 +284,8 @@ TruthValuePtr Rule::get_tv() const
 void Rule::set_name(const std::string& name)
 {
 	_name = name;
+	std::lock_guard<std::mutex> lock(_mutex);
+	_ns_rules.clear();
 }
 
 std::string& Rule::get_name()
@@ -245,6 +301,8 @@ const std::string& Rule::get_name() const
 void Rule::set_rule(const Handle& h)
 {
 	_rule = BindLinkCast(h);
+	std::lock_guard<std::mutex> lock(_mutex);
+	_ns_rules.clear();
 }
 
 Handle Rule::get_rule() const
@@ -470,34 +528,60 @@ RuleTypedSubstitutionMap Rule::unify_source(const Handle& source,
 		return {};
 
 	// To guarantee that the rule variable does not have the same name
-	// as any variable in the source. XXX This is only a stochastic
-	// guarantee, there is a small chance that the new random name
-	// will still collide.
-	Rule alpha_rule = rand_alpha_converted();
+	// as any variable in the source.
+	std::shared_ptr<const Rule> alpha_ptr = alpha_converted(source, vardecl);
+	const Rule& alpha_rule = *alpha_ptr;
 
 	RuleTypedSubstitutionMap unified_rules;
-	Handle rule_vardecl = alpha_rule.get_vardecl();
 	for (const Handle& premise : alpha_rule.get_premises())
-	{
-		Unify unify(source, premise, vardecl, rule_vardecl);
-		Unify::SolutionSet sol = unify();
-		if (sol.is_satisfiable()) {
-			Unify::TypedSubstitutions tss =
-				unify.typed_substitutions(sol, source);
-			// For each typed substitution produce a new rule by
-			// substituting all variables by their associated
-			// values.
-			for (const auto& ts : tss) {
-				Rule sed_rule = alpha_rule.substituted(ts, queried_as);
-				RuleTypedSubstitutionPair rtsp{sed_rule, ts};
-				unified_rules.insert(rtsp);
-			}
-		}
-	}
+		alpha_rule.insert_premise_unifications(premise, source, vardecl,
+		                                       queried_as, unified_rules);
+
+	return unified_rules;
+}
+
+RuleTypedSubstitutionMap Rule::unify_premise(const Handle& source,
+                                             size_t premise_index,
+                                             const Handle& vardecl,
+                                             const AtomSpace* queried_as) const
+{
+	// If the rule's handle has not been set yet
+	if (not is_valid())
+		return {};
+
+	std::shared_ptr<const Rule> alpha_ptr = alpha_converted(source, vardecl);
+	const Rule& alpha_rule = *alpha_ptr;
+
+	RuleTypedSubstitutionMap unified_rules;
+	HandleSeq premises = alpha_rule.get_premises();
+	if (premise_index < premises.size())
+		alpha_rule.insert_premise_unifications(premises[premise_index], source,
+		                                       vardecl, queried_as, unified_rules);
 
 	return unified_rules;
 }
 
+Rule Rule::member_premise(size_t premise_index, const Handle& collection) const
+{
+	// Append the membership clause to the clauses of the body, so
+	// that the pattern matcher does not see a nested AndLink
+	Handle body = get_implicant();
+	HandleSeq clauses;
+	if (body->get_type() == AND_LINK)
+		clauses = body->getOutgoingSet();
+	else
+		clauses.push_back(body);
+	Handle member = createLink(MEMBER_LINK, get_premises()[premise_index],
+	                           collection);
+	clauses.push_back(createLink(PRESENT_LINK, member));
+
+	Rule batched(*this);
+	batched.set_rule(createBindLink(get_vardecl(),
+	                                createLink(std::move(clauses), AND_LINK),
+	                                get_implicand()));
+	return batched;
+}
+
 RuleTypedSubstitutionMap Rule::unify_target(const Handle& target,
                                             const Handle& vardecl,
                                             const AtomSpace* queried_as) const
@@ -507,10 +591,9 @@ RuleTypedSubstitutionMap Rule::unify_target(const Handle& target,
 		return {};
 
 	// To guarantee that the rule variable does not have the same name
-	// as any variable in the target. XXX This is only a stochastic
-	// guarantee, there is a small chance that the new random name
-	// will still collide.
-	Rule alpha_rule = rand_alpha_converted();
+	// as any variable in the target.
+	std::shared_ptr<const Rule> alpha_ptr = alpha_converted(target, vardecl);
+	const Rule& alpha_rule = *alpha_ptr;
 
 	RuleTypedSubstitutionMap unified_rules;
 	Handle alpha_vardecl = alpha_rule.get_vardecl();
@@ -586,15 +669,67 @@ std::string Rule::to_short_string(const std::string& indent) const
 	return ss.str();
 }
 
-Rule Rule::rand_alpha_converted() const
+/**
+ * Insert the names of all variables and globs of h in names.
+ */
+static void get_variable_names(const Handle& h,
+                               std::unordered_set<std::string>& names)
 {
-	// Clone the rule
-	Rule result(*this);
-
-	// Alpha convert the rule
-	result.set_rule(_rule->alpha_convert());
+	if (not h)
+		return;
+	Type t = h->get_type();
+	if (t == VARIABLE_NODE or t == GLOB_NODE)
+		names.insert(h->get_name());
+	else if (h->is_link())
+		for (const Handle& child : h->getOutgoingSet())
+			get_variable_names(child, names);
+}
+
+std::shared_ptr<const Rule> Rule::alpha_converted(const Handle& h,
+                                                  const Handle& vardecl) const
+{
+	std::unordered_set<std::string> names;
+	get_variable_names(h, names);
+	get_variable_names(vardecl, names);
+
+	// Increase the namespace counter till none of the namespaced
+	// variables collides with the variables of h and vardecl. It
+	// terminates as h and vardecl have finitely many variables.
+	for (unsigned k = 0;; k++) {
+		std::shared_ptr<const Rule> ns_rule = get_ns_rule(k);
+		const HandleSeq& ns_vars = ns_rule->get_variables().varseq;
+		auto collides = [&](const Handle& var) {
+			return names.find(var->get_name()) != names.end(); };
+		if (std::none_of(ns_vars.begin(), ns_vars.end(), collides))
+			return ns_rule;
+	}
+}
 
-	return result;
+std::shared_ptr<const Rule> Rule::get_ns_rule(unsigned k) const
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_ns_rules.size() <= k) {
+		size_t i = _ns_rules.size();
+		std::string suffix = "@" + _name;
+		if (0 < i)
+			suffix += "#" + std::to_string(i);
+		HandleSeq ns_vars;
+		for (const Handle& var : _rule->get_variables().varseq)
+			ns_vars.push_back(createNode(var->get_type(),
+			                             var->get_name() + suffix));
+
+		// Copying locks _mutex, and so does alpha-converting in
+		// set_rule, which also discards the copied namespaced versions
+		lock.unlock();
+		std::shared_ptr<Rule> ns_rule = std::make_shared<Rule>(*this);
+		ns_rule->set_rule(_rule->alpha_convert(ns_vars));
+		lock.lock();
+
+		// Another thread may have added it meanwhile
+		if (_ns_rules.size() == i)
+			_ns_rules.push_back(ns_rule);
+	}
+	return _ns_rules[k];
 }
 
 HandleSeq Rule::get_conclusion_patterns() const
@@ -631,6 +766,28 @@ Handle Rule::get_execution_output_first_argument(const Handle& h) const
 		return args;
 }
 
+void Rule::insert_premise_unifications(const Handle& premise,
+                                      const Handle& source,
+                                      const Handle& vardecl,
+                                      const AtomSpace* queried_as,
+                                      RuleTypedSubstitutionMap& unified_rules) const
+{
+	Unify unify(source, premise, vardecl, get_vardecl());
+	Unify::SolutionSet sol = unify();
+	if (sol.is_satisfiable()) {
+		Unify::TypedSubstitutions tss =
+			unify.typed_substitutions(sol, source);
+		// For each typed substitution produce a new rule by
+		// substituting all variables by their associated
+		// values.
+		for (const auto& ts : tss) {
+			Rule sed_rule = substituted(ts, queried_as);
+			RuleTypedSubstitutionPair rtsp{sed_rule, ts};
+			unified_rules.insert(rtsp);
+		}
+	}
+}
+
 Rule Rule::substituted(const Unify::TypedSubstitution& ts,
                        const AtomSpace* queried_as) const
 {
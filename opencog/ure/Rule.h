@@ -35,6 +35,8 @@
 #include <opencog/unify/Unify.h>
 #include <opencog/util/empty_string.h>
 
+#include "AtomSpacePool.h"
+
 namespace opencog {
 
 class Rule;
@@ -49,10 +51,27 @@ class RuleSet : public std::vector<Rule>
 public:
 	/**
 	 * Run all meta rules over as and insert the resulting rules back
-	 * in the rule set.
+	 * in the rule set. The rules already produced by meta rules are
+	 * skipped without checking alpha-equivalence.
 	 */
 	void expand_meta_rules(AtomSpace& as);
 
+	/**
+	 * Like above, but only run the specializations of the meta rules
+	 * with one premise bound to one of new_atoms, typically the atoms
+	 * added to as since the previous expansion, so that only the
+	 * rules involving them are produced. The specializations are held
+	 * in a scratch atomspace borrowed from scratch_as_pool, whose
+	 * atomspaces must be children of as.
+	 */
+	void expand_meta_rules(AtomSpace& as, const HandleSet& new_atoms,
+	                       AtomSpacePool& scratch_as_pool);
+
+	/**
+	 * Return true iff the rule set contains meta rules.
+	 */
+	bool has_meta_rules() const;
+
 	/**
 	 * Return the set of rule aliases, as aliases of inference rules
 	 * are used in control rules.
@@ -79,6 +98,15 @@ public:
 
 	std::string to_string(const std::string& indent=empty_string) const;
 	std::string to_short_string(const std::string& indent=empty_string) const;
+
+private:
+	// Insert in new_rules the rules, in the SetLink result, produced
+	// by meta_rule, unless already produced.
+	void insert_meta_produced(const Rule& meta_rule, const Handle& result,
+	                          RuleSet& new_rules);
+
+	// Rules already produced by meta rules
+	HandleSet _meta_produced;
 };
 
 typedef std::map<Rule, Unify::TypedSubstitution> RuleTypedSubstitutionMap;
@@ -250,8 +278,8 @@ public:
 	/**
 	 * Used by the forward chainer to select rules. Given a source,
 	 * generate all rule variations that may be applied over a given
-	 * source. The variables in the rules are renamed to almost
-	 * certainly avoid name collision.
+	 * source. The variables in the rules are renamed to avoid name
+	 * collision (see alpha_converted).
 	 *
 	 * TODO: we probably want to support a vector of sources for rules
 	 * with multiple premises.
@@ -270,10 +298,30 @@ public:
 	                                      const Handle& vardecl=Handle::UNDEFINED,
 	                                      const AtomSpace* queried_as=nullptr) const;
 
+	/**
+	 * Like unify_source but only unify the source with the premise of
+	 * the given index (as ordered by get_premises).
+	 */
+	RuleTypedSubstitutionMap unify_premise(const Handle& source,
+	                                       size_t premise_index,
+	                                       const Handle& vardecl=Handle::UNDEFINED,
+	                                       const AtomSpace* queried_as=nullptr) const;
+
+	/**
+	 * Return a copy of this rule with an additional clause requiring
+	 * the premise of the given index to be a member of collection,
+	 * i.e. (MemberLink premise collection), so that a single query
+	 * applies the rule over all members of collection, as the
+	 * specializations obtained from unify_premise would, one source
+	 * at a time.
+	 */
+	Rule member_premise(size_t premise_index, const Handle& collection) const;
+
 	/**
 	 * Used by the backward chainer. Given a target, generate all rule
 	 * variations that may infer this target. The variables in the
-	 * rules are renamed to almost certainly avoid name collision.
+	 * rules are renamed to avoid name collision (see
+	 * alpha_converted).
 	 *
 	 * TODO: we probably want to return only typed substitutions.
 	 * However due to the unifier not supporting well same variables
@@ -344,12 +392,26 @@ private:
 	// True if the rule has already been applied.
 	bool _exhausted;
 
+	// Alpha-converted versions of the rule, where _ns_rules[k] has
+	// each variable renamed by suffixing it with @<rule name>#k (or
+	// only @<rule name> for k = 0). They are computed on demand and
+	// shared across unifications, the counter k being increased until
+	// no name collides with the variables of the source or target,
+	// which happens when these contain variables introduced by
+	// earlier expansions of the same rule.
+	mutable std::vector<std::shared_ptr<const Rule>> _ns_rules;
+
 	// NEXT TODO: subdivide in smaller and shared mutexes
 	mutable std::mutex _mutex;
 
-	// Return a copy of the rule with the variables alpha-converted
-	// into random variable names.
-	Rule rand_alpha_converted() const;
+	// Return the rule with the variables alpha-converted so that they
+	// do not collide with the variables of h or vardecl, that is the
+	// first namespaced version (see _ns_rules) that does not collide.
+	std::shared_ptr<const Rule> alpha_converted(const Handle& h,
+	                                            const Handle& vardecl) const;
+
+	// Return _ns_rules[k], computing it if necessary
+	std::shared_ptr<const Rule> get_ns_rule(unsigned k) const;
 
 	// Return the conclusion patterns of the rule. There are several
 	// of them because the conclusions can be wrapped in the
@@ -365,6 +427,14 @@ private:
 	// unify function, generate a new partially substituted rule.
 	Rule substituted(const Unify::TypedSubstitution& ts,
 	                 const AtomSpace* queried_as=nullptr) const;
+
+	// Unify source with the given premise of this (alpha-converted)
+	// rule, inserting the resulting specializations in unified_rules.
+	void insert_premise_unifications(const Handle& premise,
+	                                 const Handle& source,
+	                                 const Handle& vardecl,
+	                                 const AtomSpace* queried_as,
+	                                 RuleTypedSubstitutionMap& unified_rules) const;
 };
 
 // Debugging helpers see
@@ -0,0 +1,63 @@
+/*
+ * RuleImplicator.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <opencog/atoms/pattern/BindLink.h>
+
+#include "RuleImplicator.h"
+
+using namespace opencog;
+
+RuleImplicator::RuleImplicator(AtomSpace* as)
+	: Implicator(as),
+	  InitiateSearchCB(as),
+	  DefaultPatternMatchCB(as),
+	  DefaultImplicator(as) {}
+
+bool RuleImplicator::grounding(const HandleMap& var_soln,
+                               const HandleMap& term_soln)
+{
+	// Stop the search if cancelled
+	if (token and token->is_cancelled())
+		return true;
+
+	// Reject the grounding, but keep searching, if any of its atoms
+	// is not accepted
+	if (accept)
+		for (const auto& term_grounding : term_soln) {
+			const Handle& h = term_grounding.second;
+			if (h->getAtomSpace() and not accept(h))
+				return false;
+		}
+
+	return DefaultImplicator::grounding(var_soln, term_soln);
+}
+
+HandleSeq RuleImplicator::execute(const Handle& bindlink)
+{
+	BindLinkPtr bl(BindLinkCast(bindlink));
+	implicand = bl->get_implicand();
+	bl->satisfy(*this);
+
+	HandleSeq results;
+	for (const ValuePtr& v : get_result_set())
+		results.push_back(HandleCast(v));
+	return results;
+}
@@ -0,0 +1,73 @@
+/*
+ * RuleImplicator.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_RULEIMPLICATOR_H_
+#define _OPENCOG_URE_RULEIMPLICATOR_H_
+
+#include <functional>
+
+#include <opencog/query/DefaultImplicator.h>
+
+#include "CancellationToken.h"
+
+namespace opencog
+{
+
+/**
+ * Implicator used by the chainers to execute a rule (or a forward
+ * chaining strategy), that is a BindLink, like BindLink::execute,
+ * except that groundings can be filtered before being instantiated,
+ * and that the search can be cancelled.
+ */
+class RuleImplicator : public DefaultImplicator
+{
+public:
+	typedef std::function<bool(const Handle&)> AtomPredicate;
+
+	RuleImplicator(AtomSpace* as);
+
+	/**
+	 * If set, only accept groundings whose atoms belonging to an
+	 * atomspace all satisfy it. Other groundings, such as these of
+	 * evaluatable terms, are not checked.
+	 */
+	AtomPredicate accept;
+
+	/**
+	 * If set, the search stops at the first grounding found once it
+	 * is cancelled. The conclusions of the groundings found so far
+	 * are kept.
+	 */
+	CancellationTokenPtr token;
+
+	virtual bool grounding(const HandleMap& var_soln,
+	                       const HandleMap& term_soln);
+
+	/**
+	 * Execute the given BindLink, adding its conclusions to the
+	 * atomspace of the implicator, and return them, possibly only
+	 * part of them if the token has been cancelled meanwhile.
+	 */
+	HandleSeq execute(const Handle& bindlink);
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_RULEIMPLICATOR_H_ */
@@ -0,0 +1,176 @@
+/*
+ * Slab.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_SLAB_H_
+#define _OPENCOG_URE_SLAB_H_
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace opencog
+{
+
+/**
+ * Allocator of objects of type T, carved out of chunks of chunk_size
+ * slots. Objects never move once created, so pointers to them remain
+ * valid till they are destroyed. Destroyed slots are recycled by
+ * subsequent creations, and all remaining objects are destroyed in
+ * bulk, along with their chunks, when the slab is cleared or
+ * destroyed.
+ *
+ * Creations and destructions may happen concurrently, from several
+ * threads, as the slots are handed out and recycled under a mutex,
+ * while objects are constructed and destructed outside of it. Access
+ * to the objects themselves is up to the owner to synchronize.
+ */
+template<typename T>
+class Slab
+{
+public:
+	Slab(size_t chunk_size=64)
+		: _chunk_size(chunk_size), _used(chunk_size),
+		  _free(nullptr), _size(0) {}
+
+	~Slab() { clear(); }
+
+	Slab(const Slab&) = delete;
+	Slab& operator=(const Slab&) = delete;
+
+	/**
+	 * Construct an object with the given arguments and return its
+	 * pointer.
+	 */
+	template<typename... Args>
+	T* create(Args&&... args)
+	{
+		Slot* slot = allocate();
+		T* obj;
+		try {
+			obj = new (&slot->storage) T(std::forward<Args>(args)...);
+		} catch (...) {
+			recycle(slot);
+			throw;
+		}
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->live = true;
+		_size++;
+		return obj;
+	}
+
+	/**
+	 * Destroy an object created by this slab and recycle its slot.
+	 */
+	void destroy(T* obj)
+	{
+		obj->~T();
+		Slot* slot = reinterpret_cast<Slot*>(obj);
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->live = false;
+		slot->next_free = _free;
+		_free = slot;
+		_size--;
+	}
+
+	/**
+	 * Destroy all objects and release all chunks. Must not be called
+	 * concurrently with other operations.
+	 */
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (size_t c = 0; c < _chunks.size(); c++) {
+			size_t n = c + 1 == _chunks.size() ? _used : _chunk_size;
+			for (size_t i = 0; i < n; i++)
+				if (_chunks[c][i].live)
+					reinterpret_cast<T*>(&_chunks[c][i].storage)->~T();
+		}
+		_chunks.clear();
+		_used = _chunk_size;
+		_free = nullptr;
+		_size = 0;
+	}
+
+	/**
+	 * Number of live objects
+	 */
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _size;
+	}
+
+private:
+	// The storage comes first so that a pointer to the object is a
+	// pointer to its slot.
+	struct Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		bool live = false;
+		Slot* next_free = nullptr;
+	};
+
+	// Return a recycled slot if any, otherwise the next slot of the
+	// last chunk, allocating a new chunk if it is full.
+	Slot* allocate()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_free) {
+			Slot* slot = _free;
+			_free = slot->next_free;
+			return slot;
+		}
+		if (_used == _chunk_size) {
+			_chunks.emplace_back(new Slot[_chunk_size]);
+			_used = 0;
+		}
+		return &_chunks.back()[_used++];
+	}
+
+	// Put back a slot whose object failed to be constructed
+	void recycle(Slot* slot)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->next_free = _free;
+		_free = slot;
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> _chunks;
+
+	size_t _chunk_size;
+
+	// Number of slots handed out of the last chunk
+	size_t _used;
+
+	// Head of the list of recycled slots
+	Slot* _free;
+
+	size_t _size;
+
+	// Protect all the above
+	mutable std::mutex _mutex;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_SLAB_H_ */
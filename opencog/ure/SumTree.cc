@@ -0,0 +1,139 @@
+/*
+ * SumTree.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SumTree.h"
+
+#include <sstream>
+
+#include <opencog/util/oc_assert.h>
+
+using namespace opencog;
+
+SumTree::SumTree() : _capacity(1), _size(0), _nodes(2, 0.0) {}
+
+size_t SumTree::size() const
+{
+	return _size;
+}
+
+bool SumTree::empty() const
+{
+	return _size == 0;
+}
+
+void SumTree::push_back(double weight)
+{
+	if (_size == _capacity) {
+		// Double the capacity, move the leaves and recompute the inner
+		// nodes, amortized O(1).
+		std::vector<double> nodes(4 * _capacity, 0.0);
+		std::copy(_nodes.begin() + _capacity, _nodes.end(),
+		          nodes.begin() + 2 * _capacity);
+		_nodes.swap(nodes);
+		_capacity *= 2;
+		rebuild();
+	}
+	set(_size++, weight);
+}
+
+void SumTree::pop_back()
+{
+	OC_ASSERT(0 < _size);
+	set(--_size, 0.0);
+}
+
+void SumTree::clear()
+{
+	_capacity = 1;
+	_size = 0;
+	_nodes.assign(2, 0.0);
+}
+
+void SumTree::assign(const std::vector<double>& weights)
+{
+	_capacity = 1;
+	while (_capacity < weights.size())
+		_capacity *= 2;
+	_size = weights.size();
+	_nodes.assign(2 * _capacity, 0.0);
+	std::copy(weights.begin(), weights.end(), _nodes.begin() + _capacity);
+	rebuild();
+}
+
+void SumTree::set(size_t i, double weight)
+{
+	OC_ASSERT(i < _capacity);
+	size_t node = _capacity + i;
+	_nodes[node] = weight;
+	for (node /= 2; 0 < node; node /= 2)
+		_nodes[node] = _nodes[2 * node] + _nodes[2 * node + 1];
+}
+
+double SumTree::get(size_t i) const
+{
+	return _nodes[_capacity + i];
+}
+
+double SumTree::total() const
+{
+	return _nodes[1];
+}
+
+size_t SumTree::find(double x) const
+{
+	size_t node = 1;
+	while (node < _capacity) {
+		size_t left = 2 * node;
+		double lw = _nodes[left];
+		// Go left if x falls there, or if the right subtree has no
+		// weight, which may happen due to rounding when x is close to
+		// the total.
+		if ((x < lw and 0.0 < lw) or _nodes[left + 1] <= 0.0) {
+			node = left;
+		} else {
+			x -= lw;
+			node = left + 1;
+		}
+	}
+	return node - _capacity;
+}
+
+void SumTree::rebuild()
+{
+	for (size_t node = _capacity - 1; 0 < node; node--)
+		_nodes[node] = _nodes[2 * node] + _nodes[2 * node + 1];
+}
+
+std::string SumTree::to_string(const std::string& indent) const
+{
+	std::stringstream ss;
+	ss << indent << "size = " << _size << std::endl
+	   << indent << "total = " << total() << std::endl
+	   << indent << "weights:";
+	for (size_t i = 0; i < _size; i++)
+		ss << " " << get(i);
+	return ss.str();
+}
+
+std::string opencog::oc_to_string(const SumTree& st, const std::string& indent)
+{
+	return st.to_string(indent);
+}
@@ -0,0 +1,127 @@
+/*
+ * SumTree.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_SUMTREE_H_
+#define _OPENCOG_URE_SUMTREE_H_
+
+#include <random>
+#include <vector>
+
+#include <opencog/util/empty_string.h>
+
+namespace opencog
+{
+
+/**
+ * Sequence of non-negative weights supporting O(log n) update and
+ * O(log n) sampling of an index with probability proportional to its
+ * weight.
+ *
+ * It is a complete binary tree stored in an array, where leaves hold
+ * the weights and each inner node holds the sum of its children. Inner
+ * nodes are recomputed from their children on each update, rather than
+ * incremented, so that rounding errors do not accumulate.
+ */
+class SumTree
+{
+public:
+	SumTree();
+
+	/**
+	 * Number of weights
+	 */
+	size_t size() const;
+	bool empty() const;
+
+	/**
+	 * Append a weight at index size().
+	 */
+	void push_back(double weight);
+
+	/**
+	 * Remove the last weight.
+	 */
+	void pop_back();
+
+	/**
+	 * Remove all weights.
+	 */
+	void clear();
+
+	/**
+	 * Replace all weights by the given ones, in linear time.
+	 */
+	void assign(const std::vector<double>& weights);
+
+	/**
+	 * Set/get the weight at index i.
+	 */
+	void set(size_t i, double weight);
+	double get(size_t i) const;
+
+	/**
+	 * Sum of all weights.
+	 */
+	double total() const;
+
+	/**
+	 * Return the index i such that the sum of the weights before i is
+	 * lower than or equal to x, and x is lower than the sum of the
+	 * weights up to i included. x is assumed to be within [0, total()).
+	 *
+	 * Null weights are never found, unless all weights are null.
+	 */
+	size_t find(double x) const;
+
+	/**
+	 * Sample an index with probability proportional to its weight,
+	 * using the given random generator. The total weight is assumed to
+	 * be positive.
+	 */
+	template<typename Generator>
+	size_t sample(Generator& gen) const
+	{
+		std::uniform_real_distribution<double> dist(0.0, total());
+		return find(dist(gen));
+	}
+
+	std::string to_string(const std::string& indent=empty_string) const;
+
+private:
+	// Recompute the inner nodes from the leaves
+	void rebuild();
+
+	// Number of leaves allocated, always a power of 2
+	size_t _capacity;
+
+	// Number of weights
+	size_t _size;
+
+	// Nodes of the tree, the root is at 1, the children of node i
+	// are at 2i and 2i+1, leaves are at [_capacity, 2*_capacity).
+	std::vector<double> _nodes;
+};
+
+std::string oc_to_string(const SumTree& st,
+                         const std::string& indent=empty_string);
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_SUMTREE_H_ */
@@ -29,6 +29,8 @@
 
 #include <opencog/atoms/base/Handle.h>
 
+#include "URERandGen.h"
+
 namespace opencog {
 
 ThompsonSampling::ThompsonSampling(const TruthValueSeq& tvs, unsigned bins)
@@ -63,7 +65,7 @@ size_t ThompsonSampling::operator()()
 {
 	std::vector<double> weights = distribution();
 	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	return dist(randGen());
+	return dist(ure_randgen());
 }
 
 double ThompsonSampling::Pi(size_t i,
@@ -0,0 +1,102 @@
+/*
+ * ThreadPool.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ThreadPool.h"
+
+using namespace opencog;
+
+ThreadPool::ThreadPool(unsigned size) : _pending(0), _stop(false)
+{
+	reserve(size);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done_cv.wait(lock, [&]() { return _pending == 0; });
+		_stop = true;
+	}
+	_task_cv.notify_all();
+	for (std::thread& worker : _workers)
+		worker.join();
+}
+
+void ThreadPool::reserve(unsigned n)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	while (_workers.size() < n)
+		_workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+void ThreadPool::push(const Task& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(task);
+		_pending++;
+	}
+	_task_cv.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done_cv.wait(lock, [&]() { return _pending == 0; });
+	if (_exception) {
+		std::exception_ptr e = _exception;
+		_exception = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+unsigned ThreadPool::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _workers.size();
+}
+
+void ThreadPool::worker_loop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_task_cv.wait(lock, [&]() { return _stop or not _tasks.empty(); });
+		if (_tasks.empty())
+			return;             // _stop is set and no task is left
+
+		Task task = std::move(_tasks.front());
+		_tasks.pop_front();
+		lock.unlock();
+
+		try {
+			task();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> elock(_mutex);
+			if (not _exception)
+				_exception = std::current_exception();
+		}
+
+		lock.lock();
+		if (--_pending == 0)
+			_done_cv.notify_all();
+	}
+}
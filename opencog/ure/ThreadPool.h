@@ -0,0 +1,109 @@
+/*
+ * ThreadPool.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_THREADPOOL_H_
+#define _OPENCOG_URE_THREADPOOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace opencog
+{
+
+/**
+ * Pool of long-lived worker threads, meant to be owned by a chainer
+ * (or shared between chainers) so that multi-threaded chaining does
+ * not pay for thread creation at each iteration.
+ *
+ * Tasks are pushed in a FIFO queue and executed by the first idle
+ * worker. wait() blocks until all pushed tasks have completed.
+ */
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	/**
+	 * Create a pool with the given number of workers. Workers can be
+	 * added later on with reserve.
+	 */
+	ThreadPool(unsigned size=0);
+
+	/**
+	 * Wait for the pending tasks to complete, then join all workers.
+	 */
+	~ThreadPool();
+
+	/**
+	 * Make sure the pool has at least n workers.
+	 */
+	void reserve(unsigned n);
+
+	/**
+	 * Push a task to be executed by some worker.
+	 */
+	void push(const Task& task);
+
+	/**
+	 * Block until all pushed tasks have completed. If any task has
+	 * thrown an exception, the first one is rethrown here.
+	 */
+	void wait();
+
+	/**
+	 * Return the number of workers.
+	 */
+	unsigned size() const;
+
+private:
+	// Loop run by each worker, executing tasks as they come
+	void worker_loop();
+
+	std::vector<std::thread> _workers;
+
+	// Tasks waiting to be executed
+	std::deque<Task> _tasks;
+
+	// Number of tasks pushed but not completed yet (queued or running)
+	size_t _pending;
+
+	// Set to true when the workers must exit
+	bool _stop;
+
+	// First exception thrown by a task since the last wait()
+	std::exception_ptr _exception;
+
+	mutable std::mutex _mutex;
+
+	// Notify the workers that a task is available or that they must stop
+	std::condition_variable _task_cv;
+
+	// Notify the waiters that all tasks have completed
+	std::condition_variable _done_cv;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_THREADPOOL_H_ */
@@ -36,8 +36,16 @@ const std::string UREConfig::top_rbs_name = "URE";
 const std::string UREConfig::max_iter_name = "URE:maximum-iterations";
 const std::string UREConfig::complexity_penalty_name = "URE:complexity-penalty";
 const std::string UREConfig::jobs_name = "URE:jobs";
+const std::string UREConfig::max_time_name = "URE:maximum-time";
+const std::string UREConfig::max_kb_additions_name = "URE:maximum-kb-additions";
+const std::string UREConfig::max_population_size_name = "URE:maximum-population-size";
+const std::string UREConfig::random_seed_name = "URE:random-seed";
 const std::string UREConfig::fc_retry_exhausted_sources_name = "URE:FC:retry-exhausted-sources";
 const std::string UREConfig::fc_full_rule_application_name = "URE:FC:full-rule-application";
+const std::string UREConfig::fc_semi_naive_rule_application_name = "URE:FC:semi-naive-rule-application";
+const std::string UREConfig::fc_max_source_set_size_name = "URE:FC:maximum-source-set-size";
+const std::string UREConfig::fc_batch_size_name = "URE:FC:batch-size";
+const std::string UREConfig::fc_deterministic_name = "URE:FC:deterministic";
 const std::string UREConfig::bc_max_bit_size_name = "URE:BC:maximum-bit-size";
 const std::string UREConfig::bc_mm_complexity_penalty_name = "URE:BC:MM:complexity-penalty";
 const std::string UREConfig::bc_mm_compressiveness_name = "URE:BC:MM:compressiveness";
@@ -78,6 +86,26 @@ int UREConfig::get_jobs() const
 	return _common_params.jobs;
 }
 
+double UREConfig::get_maximum_time() const
+{
+	return _common_params.max_time;
+}
+
+int UREConfig::get_maximum_kb_additions() const
+{
+	return _common_params.max_kb_additions;
+}
+
+int UREConfig::get_maximum_population_size() const
+{
+	return _common_params.max_population_size;
+}
+
+int UREConfig::get_random_seed() const
+{
+	return _common_params.random_seed;
+}
+
 bool UREConfig::get_retry_exhausted_sources() const
 {
 	return _fc_params.retry_exhausted_sources;
@@ -88,6 +116,26 @@ bool UREConfig::get_full_rule_application() const
 	return _fc_params.full_rule_application;
 }
 
+bool UREConfig::get_semi_naive_rule_application() const
+{
+	return _fc_params.semi_naive_rule_application;
+}
+
+int UREConfig::get_maximum_source_set_size() const
+{
+	return _fc_params.max_source_set_size;
+}
+
+int UREConfig::get_batch_size() const
+{
+	return _fc_params.batch_size;
+}
+
+bool UREConfig::get_deterministic() const
+{
+	return _fc_params.deterministic;
+}
+
 double UREConfig::get_max_bit_size() const
 {
 	return _bc_params.max_bit_size;
@@ -125,6 +173,26 @@ void UREConfig::set_jobs(int j)
 	_common_params.jobs = j;
 }
 
+void UREConfig::set_maximum_time(double mt)
+{
+	_common_params.max_time = mt;
+}
+
+void UREConfig::set_maximum_kb_additions(int mka)
+{
+	_common_params.max_kb_additions = mka;
+}
+
+void UREConfig::set_maximum_population_size(int mps)
+{
+	_common_params.max_population_size = mps;
+}
+
+void UREConfig::set_random_seed(int rs)
+{
+	_common_params.random_seed = rs;
+}
+
 void UREConfig::set_retry_exhausted_sources(bool rs)
 {
 	_fc_params.retry_exhausted_sources = rs;
@@ -135,6 +203,26 @@ void UREConfig::set_full_rule_application(bool rs)
 	_fc_params.full_rule_application = rs;
 }
 
+void UREConfig::set_semi_naive_rule_application(bool snra)
+{
+	_fc_params.semi_naive_rule_application = snra;
+}
+
+void UREConfig::set_maximum_source_set_size(int mss)
+{
+	_fc_params.max_source_set_size = mss;
+}
+
+void UREConfig::set_batch_size(int bs)
+{
+	_fc_params.batch_size = bs;
+}
+
+void UREConfig::set_deterministic(bool d)
+{
+	_fc_params.deterministic = d;
+}
+
 void UREConfig::set_mm_complexity_penalty(double mm_cp)
 {
 	_bc_params.mm_complexity_penalty = mm_cp;
@@ -185,6 +273,16 @@ void UREConfig::fetch_common_parameters(const Handle& rbs)
 
 	// Fetch number of jobs
 	_common_params.jobs = fetch_num_param(jobs_name, rbs, 1);
+
+	// Fetch budgets
+	_common_params.max_time = fetch_num_param(max_time_name, rbs, -1);
+	_common_params.max_kb_additions =
+		fetch_num_param(max_kb_additions_name, rbs, -1);
+	_common_params.max_population_size =
+		fetch_num_param(max_population_size_name, rbs, -1);
+
+	// Fetch random seed
+	_common_params.random_seed = fetch_num_param(random_seed_name, rbs, -1);
 }
 
 void UREConfig::fetch_fc_parameters(const Handle& rbs)
@@ -194,6 +292,13 @@ void UREConfig::fetch_fc_parameters(const Handle& rbs)
 		fetch_bool_param(fc_retry_exhausted_sources_name, rbs, false);
 	_fc_params.full_rule_application =
 		fetch_bool_param(fc_full_rule_application_name, rbs, false);
+	_fc_params.semi_naive_rule_application =
+		fetch_bool_param(fc_semi_naive_rule_application_name, rbs, false);
+	_fc_params.max_source_set_size =
+		fetch_num_param(fc_max_source_set_size_name, rbs, -1);
+	_fc_params.batch_size = fetch_num_param(fc_batch_size_name, rbs, 1);
+	_fc_params.deterministic =
+		fetch_bool_param(fc_deterministic_name, rbs, false);
 }
 
 void UREConfig::fetch_bc_parameters(const Handle& rbs)
@@ -63,9 +63,17 @@ public:
 	int get_maximum_iterations() const;
 	double get_complexity_penalty() const;
 	int get_jobs() const;
+	double get_maximum_time() const;
+	int get_maximum_kb_additions() const;
+	int get_maximum_population_size() const;
+	int get_random_seed() const;
 	// FC
 	bool get_retry_exhausted_sources() const;
 	bool get_full_rule_application() const;
+	bool get_semi_naive_rule_application() const;
+	int get_maximum_source_set_size() const;
+	int get_batch_size() const;
+	bool get_deterministic() const;
 	// BC
 	double get_max_bit_size() const;
 	double get_mm_complexity_penalty() const;
@@ -83,9 +91,17 @@ public:
 	void set_maximum_iterations(int);
 	void set_complexity_penalty(double);
 	void set_jobs(int);
+	void set_maximum_time(double);
+	void set_maximum_kb_additions(int);
+	void set_maximum_population_size(int);
+	void set_random_seed(int);
 	// FC
 	void set_retry_exhausted_sources(bool);
 	void set_full_rule_application(bool);
+	void set_semi_naive_rule_application(bool);
+	void set_maximum_source_set_size(int);
+	void set_batch_size(int);
+	void set_deterministic(bool);
 	// BC
 	void set_mm_complexity_penalty(double);
 	void set_mm_compressiveness(double);
@@ -109,6 +125,21 @@ public:
 	// Name of the jobs parameter
 	static const std::string jobs_name;
 
+	// Name of the maximum wall-clock time parameter, in seconds
+	static const std::string max_time_name;
+
+	// Name of the maximum number of atoms added to the knowledge base
+	// parameter
+	static const std::string max_kb_additions_name;
+
+	// Name of the maximum population size parameter, the number of
+	// sources for the forward chainer, the number of and-BITs for the
+	// backward chainer.
+	static const std::string max_population_size_name;
+
+	// Name of the random seed parameter
+	static const std::string random_seed_name;
+
 	// Name of the PredicateNode outputting whether sources should be
 	// retried after exhaustion
 	static const std::string fc_retry_exhausted_sources_name;
@@ -118,6 +149,24 @@ public:
 	// source.
 	static const std::string fc_full_rule_application_name;
 
+	// Name of the PredicateNode outputting whether, under full rule
+	// application, a rule already applied should only be applied over
+	// the atoms produced since its last application.
+	static const std::string fc_semi_naive_rule_application_name;
+
+	// Name of the NumberNode holding the maximum number of sources
+	// of the population, beyond which the least promising are evicted
+	static const std::string fc_max_source_set_size_name;
+
+	// Name of the NumberNode holding the number of sources expanded
+	// per iteration
+	static const std::string fc_batch_size_name;
+
+	// Name of the PredicateNode outputting whether the results of the
+	// multi-threaded forward chainer should only depend on the random
+	// seed and the number of jobs.
+	static const std::string fc_deterministic_name;
+
 	// Name of the maximum number of and-BITs in the BIT parameter
 	static const std::string bc_max_bit_size_name;
 
@@ -149,8 +198,30 @@ private:
 		// reasoning. Note that the number of jobs can have an effect on
 		// the results, especially for the forward chainer because the
 		// result of applying a rule may depend on the output of
-		// applying other rules.
+		// applying other rules. The backward chainer expands and
+		// fulfills several of its and-BITs in parallel.
 		int jobs;
+
+		// Budgets, checked at iteration boundaries, beyond which the
+		// chainer terminates. Negative means unlimited.
+		//
+		// Maximum wall-clock time of the chaining in seconds.
+		double max_time;
+
+		// Maximum number of atoms added to the knowledge base
+		// atomspace during the chaining.
+		int max_kb_additions;
+
+		// Maximum number of sources (for the forward chainer) or
+		// and-BITs (for the backward chainer). It is a proxy for the
+		// memory used by the chainer, the bulk of which lies in its
+		// population.
+		int max_population_size;
+
+		// Master seed of the random generators of the chainer, each
+		// worker drawing from its own stream derived from it. Negative
+		// means using the global random generator, unseeded.
+		int random_seed;
 	};
 	CommonParameters _common_params;
 
@@ -162,6 +233,29 @@ private:
 		// Apply the selected rule over the entire atomspace, not just
 		// the selected source.
 		bool full_rule_application;
+
+		// Under full rule application, only apply a rule over the
+		// atoms produced since its last application (semi-naive
+		// evaluation), rather than re-applying it over the entire
+		// atomspace.
+		bool semi_naive_rule_application;
+
+		// Maximum number of sources of the population. Beyond that
+		// the least promising sources are evicted. Negative means
+		// unbounded.
+		int max_source_set_size;
+
+		// Number of sources sampled per iteration. Sources sharing
+		// the same selected rule have that rule applied once, which
+		// mostly happens in full rule application mode.
+		int batch_size;
+
+		// Run the multi-threaded chainer in rounds of jobs
+		// iterations, selecting sources and rules, then applying rules
+		// in parallel, then committing their results in iteration
+		// order, so that results only depend on the random seed and
+		// the number of jobs. Batch size is ignored in that mode.
+		bool deterministic;
 };
 	FCParameters _fc_params;
 
@@ -0,0 +1,56 @@
+/*
+ * URERandGen.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <cstdint>
+
+#include "URERandGen.h"
+
+namespace opencog {
+
+// Generator installed on the calling thread, if any
+static thread_local MT19937RandGen* thread_randgen = nullptr;
+
+MT19937RandGen& ure_randgen()
+{
+	return thread_randgen ? *thread_randgen : randGen();
+}
+
+unsigned long derive_seed(unsigned long seed, unsigned long index)
+{
+	// SplitMix64 finalizer over the combined seed and index
+	uint64_t z = (uint64_t)seed + 0x9e3779b97f4a7c15ULL * (index + 1);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return (unsigned long)(z ^ (z >> 31));
+}
+
+ScopedRandGen::ScopedRandGen(unsigned long seed)
+	: _gen(seed), _prev(thread_randgen)
+{
+	thread_randgen = &_gen;
+}
+
+ScopedRandGen::~ScopedRandGen()
+{
+	thread_randgen = _prev;
+}
+
+} // ~namespace opencog
@@ -0,0 +1,78 @@
+/*
+ * URERandGen.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef _OPENCOG_URE_RANDGEN_H_
+#define _OPENCOG_URE_RANDGEN_H_
+
+#include <iterator>
+
+#include <opencog/util/mt19937ar.h>
+
+namespace opencog
+{
+
+/**
+ * Random generator of the calling thread, that is the one installed
+ * by the innermost ScopedRandGen of that thread if any, otherwise the
+ * global randGen().
+ *
+ * This lets each worker of a multi-threaded chainer draw from its own
+ * seeded stream, so that runs are reproducible and workers do not
+ * contend on randGen().
+ */
+MT19937RandGen& ure_randgen();
+
+/**
+ * Derive the seed of a stream, such as the stream of a worker, from a
+ * master seed, so that the streams of different indices are
+ * decorrelated.
+ */
+unsigned long derive_seed(unsigned long seed, unsigned long index);
+
+/**
+ * Install a generator with the given seed on the calling thread for
+ * the lifetime of the object. Scopes may be nested, the previous
+ * generator being restored upon destruction.
+ */
+class ScopedRandGen
+{
+public:
+	explicit ScopedRandGen(unsigned long seed);
+	ScopedRandGen(const ScopedRandGen&) = delete;
+	ScopedRandGen& operator=(const ScopedRandGen&) = delete;
+	~ScopedRandGen();
+
+private:
+	MT19937RandGen _gen;
+	MT19937RandGen* _prev;
+};
+
+/**
+ * Like rand_element of cogutil but draw from ure_randgen().
+ */
+template<typename C, typename Distribution>
+auto ure_rand_element(C& c, Distribution& dist) -> decltype(*c.begin())
+{
+	return *std::next(c.begin(), dist(ure_randgen()));
+}
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_URE_RANDGEN_H_ */
@@ -45,6 +45,10 @@ protected:
 	 *                     chaining will be applied.  If the set link is
 	 *                     empty, chaining will be invoked on the entire
 	 *                     atomspace.
+	 * @param subscriber   A predicate evaluated over each new product as
+	 *                     soon as it is produced, cancelling the chaining
+	 *                     if it returns false. An empty ListLink means no
+	 *                     subscriber.
 	 *
 	 * @return             A SetLink containing the results of FC inference.
 	 */
@@ -53,7 +57,8 @@ protected:
 	                           Handle vardecl,
 	                           bool trace_enabled,
 	                           AtomSpace *trace_as,
-	                           Handle focus_set);
+	                           Handle focus_set,
+	                           Handle subscriber);
 
 	/**
 	 * The scheme (cog-mandatory-args-bc) function calls this, to
@@ -123,7 +128,8 @@ Handle URESCM::do_forward_chaining(Handle rbs,
                                    Handle vardecl,
                                    bool trace_enabled,
                                    AtomSpace *trace_as,
-                                   Handle focus_set_h)
+                                   Handle focus_set_h,
+                                   Handle subscriber)
 {
 	AtomSpace *as = SchemeSmob::ss_get_env_as("cog-mandatory-args-fc");
 	HandleSeq focus_set = {};
@@ -143,6 +149,11 @@ Handle URESCM::do_forward_chaining(Handle rbs,
 			"URESCM::do_forward_chaining - focus set should be SET_LINK type!");
 
 	ForwardChainer fc(*as, rbs, source, vardecl, trace_as, focus_set);
+
+	// A ListLink means that there is no subscriber
+	if (subscriber->get_type() != LIST_LINK)
+		fc.subscribe(subscriber);
+
 	fc.do_chain();
 	return fc.get_results();
 }
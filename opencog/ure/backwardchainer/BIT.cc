@@ -21,13 +21,10 @@
  */
 
 #include <boost/range/algorithm/binary_search.hpp>
-#include <boost/range/algorithm/lower_bound.hpp>
 #include <boost/range/algorithm/reverse.hpp>
 #include <boost/range/algorithm/unique.hpp>
-#include <boost/range/algorithm/find.hpp>
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/range/algorithm_ext/erase.hpp>
-#include <boost/algorithm/cxx11/all_of.hpp>
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -43,6 +40,7 @@
 
 #include "BIT.h"
 #include "../URELogger.h"
+#include "../URERandGen.h"
 
 namespace opencog {
 
@@ -87,11 +85,14 @@ std::string	BITNode::to_string(const std::string& indent) const
 // AndBIT //
 ////////////
 
-AndBIT::AndBIT() : complexity(0), exhausted(false), queried_as(nullptr) {}
+AndBIT::AndBIT()
+	: complexity(0), exhausted(false), queried_as(nullptr), index(0) {}
 
 AndBIT::AndBIT(AtomSpace& bit_as, const Handle& target, Handle vardecl,
-               const BITNodeFitness& fitness, const AtomSpace* qas)
-	: exhausted(false), queried_as(qas)
+               const BITNodeFitness& fitness, const AtomSpace* qas,
+               BITNodeSlabPtr slab)
+	: bitnode_slab(slab ? slab : std::make_shared<Slab<BITNode>>()),
+	  exhausted(false), queried_as(qas), index(0)
 {
 	// Create initial FCS
 	vardecl = gen_vardecl(target, vardecl); // in case it is undefined
@@ -105,16 +106,70 @@ AndBIT::AndBIT(AtomSpace& bit_as, const Handle& target, Handle vardecl,
 
 	// Insert the initial BITNode and initialize the AndBIT complexity
 	auto it = insert_bitnode(target, fitness);
-	complexity = it->second.complexity;
+	complexity = it->second->complexity;
 }
 
-AndBIT::AndBIT(const Handle& f, double cpx, const AtomSpace* qas)
-	: fcs(f), complexity(cpx), exhausted(false), queried_as(qas)
+AndBIT::AndBIT(const Handle& f, double cpx, const AtomSpace* qas,
+               BITNodeSlabPtr slab)
+	: fcs(f), bitnode_slab(slab ? slab : std::make_shared<Slab<BITNode>>()),
+	  complexity(cpx), exhausted(false), queried_as(qas), index(0)
 {
 	set_leaf2bitnode();         // TODO: might differ till needed to optimize
 }
 
-AndBIT::~AndBIT() {}
+AndBIT::~AndBIT()
+{
+	destroy_bitnodes();
+}
+
+AndBIT::AndBIT(const AndBIT& other)
+	: fcs(other.fcs), bitnode_slab(other.bitnode_slab),
+	  complexity(other.complexity), exhausted(other.exhausted),
+	  queried_as(other.queried_as), index(other.index)
+{
+	copy_bitnodes(other.leaf2bitnode);
+}
+
+AndBIT::AndBIT(AndBIT&& other)
+	: fcs(std::move(other.fcs)),
+	  leaf2bitnode(std::move(other.leaf2bitnode)),
+	  bitnode_slab(std::move(other.bitnode_slab)),
+	  complexity(other.complexity), exhausted(other.exhausted),
+	  queried_as(other.queried_as), index(other.index)
+{
+	other.leaf2bitnode.clear();
+}
+
+AndBIT& AndBIT::operator=(const AndBIT& other)
+{
+	if (this == &other)
+		return *this;
+	destroy_bitnodes();
+	fcs = other.fcs;
+	bitnode_slab = other.bitnode_slab;
+	copy_bitnodes(other.leaf2bitnode);
+	complexity = other.complexity;
+	exhausted = other.exhausted;
+	queried_as = other.queried_as;
+	index = other.index;
+	return *this;
+}
+
+AndBIT& AndBIT::operator=(AndBIT&& other)
+{
+	if (this == &other)
+		return *this;
+	destroy_bitnodes();
+	fcs = std::move(other.fcs);
+	leaf2bitnode = std::move(other.leaf2bitnode);
+	other.leaf2bitnode.clear();
+	bitnode_slab = std::move(other.bitnode_slab);
+	complexity = other.complexity;
+	exhausted = other.exhausted;
+	queried_as = other.queried_as;
+	index = other.index;
+	return *this;
+}
 
 AndBIT AndBIT::expand(const Handle& leaf,
                       const RuleTypedSubstitutionPair& rule,
@@ -139,7 +194,7 @@ AndBIT AndBIT::expand(const Handle& leaf,
 		return AndBIT();
 	}
 
-	return AndBIT(new_fcs, new_cpx, queried_as);
+	return AndBIT(new_fcs, new_cpx, queried_as, bitnode_slab);
 }
 
 BITNode* AndBIT::select_leaf()
@@ -150,7 +205,7 @@ BITNode* AndBIT::select_leaf()
 	std::vector<double> weights;
 	bool all_weights_null = true;
 	for (const auto& lb : leaf2bitnode) {
-		double p = lb.second();
+		double p = (*lb.second)();
 		weights.push_back(p);
 		if (p > 0) all_weights_null = false;
 	}
@@ -161,13 +216,13 @@ BITNode* AndBIT::select_leaf()
 
 	// If well defined then sample according to it
 	LeafDistribution dist(weights.begin(), weights.end());
-	return &rand_element(leaf2bitnode, dist).second;
+	return ure_rand_element(leaf2bitnode, dist).second;
 }
 
 void AndBIT::reset_exhausted()
 {
 	for (auto& el : leaf2bitnode)
-		el.second.exhausted = false;
+		el.second->exhausted = false;
 	exhausted = false;
 }
 
@@ -307,7 +362,7 @@ double AndBIT::expand_complexity(const Handle& leaf, double prob) const
 	// complexity of the parent and-BIT with the complexity of the
 	// expanded BIT-node and the complexity of the rule (1 - log(prob))
 	return complexity
-		+ leaf2bitnode.find(leaf)->second.complexity
+		+ leaf2bitnode.find(leaf)->second->complexity
 		+ 1 - log(prob);
 }
 
@@ -368,10 +423,37 @@ AndBIT::insert_bitnode(Handle leaf, const BITNodeFitness& fitness)
 
 	HandleBITNodeMap::iterator it = leaf2bitnode.find(leaf);
 	if (it == leaf2bitnode.end())
-		return leaf2bitnode.emplace(leaf, BITNode(leaf, fitness)).first;
+		return leaf2bitnode.emplace(leaf,
+		                            bitnode_slab->create(leaf, fitness)).first;
 	return it;
 }
 
+void AndBIT::copy_bitnodes(const HandleBITNodeMap& other)
+{
+	leaf2bitnode.clear();
+	leaf2bitnode.reserve(other.size());
+	for (const auto& lb : other)
+		leaf2bitnode.emplace(lb.first, bitnode_slab->create(*lb.second));
+}
+
+void AndBIT::set_bitnode_slab(BITNodeSlabPtr slab)
+{
+	HandleBITNodeMap old_leaf2bitnode;
+	old_leaf2bitnode.swap(leaf2bitnode);
+	BITNodeSlabPtr old_slab = bitnode_slab;
+	bitnode_slab = slab;
+	copy_bitnodes(old_leaf2bitnode);
+	for (const auto& lb : old_leaf2bitnode)
+		old_slab->destroy(lb.second);
+}
+
+void AndBIT::destroy_bitnodes()
+{
+	for (const auto& lb : leaf2bitnode)
+		bitnode_slab->destroy(lb.second);
+	leaf2bitnode.clear();
+}
+
 HandleSet AndBIT::get_leaves() const
 {
 	return get_leaves(fcs);
@@ -726,14 +808,25 @@ std::string AndBIT::line_separator(const std::string& up_aa,
 // BIT //
 /////////
 
-BIT::BIT() : _as(nullptr) {}
+// Default and-BIT weight
+static double default_andbit_weight(const AndBIT& andbit)
+{
+	return andbit.exhausted ? 0.0 : 1.0;
+}
+
+BIT::BIT()
+	: _as(nullptr), _bitnode_slab(std::make_shared<Slab<BITNode>>()),
+	  _andbit_weight(default_andbit_weight),
+	  _exhausted_count(0) {}
 
 BIT::BIT(AtomSpace& as,
          const Handle& target,
          const Handle& vardecl,
          const BITNodeFitness& fitness)
 	: bit_as(&as), // child atomspace of as
-	  _as(&as), _init_target(target), _init_vardecl(vardecl),
+	  _as(&as), _bitnode_slab(std::make_shared<Slab<BITNode>>()),
+	  _andbit_weight(default_andbit_weight),
+	  _exhausted_count(0), _init_target(target), _init_vardecl(vardecl),
 	  _init_fitness(fitness) {}
 
 BIT::~BIT() {}
@@ -750,59 +843,186 @@ size_t BIT::size() const
 
 AndBIT* BIT::init()
 {
-	andbits.emplace_back(bit_as, _init_target,
-	                     _init_vardecl, _init_fitness, _as);
+	AndBIT* andbit = add(_andbit_slab.create(bit_as, _init_target,
+	                                         _init_vardecl, _init_fitness,
+	                                         _as, _bitnode_slab));
 
 	LAZY_URE_LOG_DEBUG << "Initialize BIT with:" << std::endl
-	                   << andbits.begin()->to_string();
+	                   << andbit->to_string();
 
-	return &*andbits.begin();
+	return andbit;
 }
 
 AndBIT* BIT::expand(AndBIT& andbit, BITNode& bitleaf,
                     const RuleTypedSubstitutionPair& rule, double prob)
+{
+	// Expand the and-BIT and insert it in the BIT, if the expansion
+	// was successful
+	AndBIT new_andbit = expansion(andbit, bitleaf, rule, prob);
+	return (bool)new_andbit.fcs ? insert(std::move(new_andbit)) : nullptr;
+}
+
+AndBIT BIT::expansion(AndBIT& andbit, BITNode& bitleaf,
+                      const RuleTypedSubstitutionPair& rule,
+                      double prob) const
 {
 	// Make sure that the rule is not already an or-child of bitleaf.
 	if (is_in(rule, bitleaf)) {
 		ure_logger().debug() << "An equivalent rule has already expanded "
 		                     << "that BIT-node, abort expansion";
-		return nullptr;
+		return AndBIT();
 	}
 
 	// Insert the rule as or-branch of this bitleaf
 	bitleaf.rules.insert(rule);
 
-	// Expand the and-BIT and insert it in the BIT, if the expansion
-	// was successful
-	AndBIT new_andbit = andbit.expand(bitleaf.body, rule, prob);
-	return (bool)new_andbit.fcs ? insert(new_andbit) : nullptr;
+	return andbit.expand(bitleaf.body, rule, prob);
+}
+
+AndBIT* BIT::insert(const AndBIT& andbit)
+{
+	if (is_duplicate(andbit))
+		return nullptr;
+	return add(_andbit_slab.create(andbit));
 }
 
-AndBIT* BIT::insert(AndBIT& andbit)
+AndBIT* BIT::insert(AndBIT&& andbit)
 {
-	// Check that it isn't already in the BIT
-	if (boost::find(andbits, andbit) != andbits.end()) {
-		LAZY_URE_LOG_DEBUG << "The following and-BIT is already in the BIT: "
-		                   << andbit.fcs->id_to_string();
+	if (is_duplicate(andbit))
 		return nullptr;
+	return add(_andbit_slab.create(std::move(andbit)));
+}
+
+bool BIT::is_duplicate(const AndBIT& andbit) const
+{
+	if (_fcs_index.find(andbit.fcs) == _fcs_index.end())
+		return false;
+
+	LAZY_URE_LOG_DEBUG << "The following and-BIT is already in the BIT: "
+	                   << andbit.fcs->id_to_string();
+	return true;
+}
+
+AndBIT* BIT::add(AndBIT* andbit)
+{
+	// Move the BIT-nodes of and-BITs created outside of the BIT into
+	// its slab
+	if (andbit->bitnode_slab != _bitnode_slab)
+		andbit->set_bitnode_slab(_bitnode_slab);
+
+	andbit->index = andbits.size();
+	andbits.push_back(andbit);
+	_fcs_index.emplace(andbit->fcs, andbit);
+	_sampler.push_back(_andbit_weight(*andbit));
+	if (andbit->exhausted)
+		_exhausted_count++;
+	return andbit;
+}
+
+size_t BIT::remove(AndBIT* andbit)
+{
+	size_t i = andbit->index, last = andbits.size() - 1;
+	_fcs_index.erase(andbit->fcs);
+	if (andbit->exhausted)
+		_exhausted_count--;
+	if (i != last) {
+		// Move the last and-BIT in place of andbit
+		AndBITs::auto_type moved = andbits.pop_back();
+		moved->index = i;
+		_sampler.set(i, _sampler.get(last));
+		andbits.replace(i, moved.release());
+	} else {
+		andbits.pop_back();
+	}
+	_sampler.pop_back();
+	_andbit_slab.destroy(andbit);
+	return i;
+}
+
+AndBIT* BIT::find(const Handle& fcs) const
+{
+	auto it = _fcs_index.find(fcs);
+	return it == _fcs_index.end() ? nullptr : it->second;
+}
+
+void BIT::erase(const std::vector<AndBIT*>& victims)
+{
+	if (victims.empty())
+		return;
+
+	std::vector<bool> erased(andbits.size(), false);
+	for (const AndBIT* andbit : victims)
+		erased[andbit->index] = true;
+
+	// Move the remaining and-BITs and their weights in new
+	// containers, while erasing the others.
+	AndBITs kept;
+	std::vector<double> weights;
+	kept.reserve(andbits.size());
+	weights.reserve(andbits.size());
+	for (size_t i = 0; i < andbits.size(); i++) {
+		AndBIT* andbit = &andbits[i];
+		if (erased[i]) {
+			_fcs_index.erase(andbit->fcs);
+			if (andbit->exhausted)
+				_exhausted_count--;
+			remove_hypergraph(bit_as, andbit->fcs);
+			_andbit_slab.destroy(andbit);
+		} else {
+			andbit->index = kept.size();
+			kept.push_back(andbit);
+			weights.push_back(_sampler.get(i));
+		}
 	}
-	// Insert while keeping the order
-	auto it = andbits.insert(boost::lower_bound(andbits, andbit), andbit);
+	andbits.swap(kept);
+	_sampler.assign(weights);
+}
 
-	// Return andbit pointer
-	return &*it;
+void BIT::set_exhausted(AndBIT& andbit)
+{
+	if (andbit.exhausted)
+		return;
+	andbit.exhausted = true;
+	_exhausted_count++;
+	_sampler.set(andbit.index, _andbit_weight(andbit));
 }
 
 void BIT::reset_exhausted_flags()
 {
-	for (AndBIT& andbit : andbits)
+	for (AndBIT& andbit : andbits) {
 		andbit.reset_exhausted();
+		_sampler.set(andbit.index, _andbit_weight(andbit));
+	}
+	_exhausted_count = 0;
 }
 
 bool BIT::andbits_exhausted() const
 {
-	return boost::algorithm::all_of(andbits, [](const AndBIT& andbit) {
-			return andbit.exhausted; });
+	return _exhausted_count == andbits.size();
+}
+
+void BIT::set_andbit_weight(const AndBITWeight& weight)
+{
+	_andbit_weight = weight;
+	for (const AndBIT& andbit : andbits)
+		_sampler.set(andbit.index, _andbit_weight(andbit));
+}
+
+double BIT::get_weight(const AndBIT& andbit) const
+{
+	return _sampler.get(andbit.index);
+}
+
+double BIT::total_weight() const
+{
+	return _sampler.total();
+}
+
+AndBIT* BIT::sample()
+{
+	if (_sampler.total() <= 0.0)
+		return nullptr;
+	return &andbits[_sampler.sample(ure_randgen())];
 }
 
 bool BIT::is_in(const RuleTypedSubstitutionPair& rule,
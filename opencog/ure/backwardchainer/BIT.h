@@ -23,10 +23,17 @@
 #ifndef _OPENCOG_BIT_H
 #define _OPENCOG_BIT_H
 
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
 #include <boost/operators.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 
 #include <opencog/util/empty_string.h>
 #include <opencog/ure/Rule.h>
+#include <opencog/ure/Slab.h>
+#include <opencog/ure/SumTree.h>
 #include <opencog/atoms/base/Handle.h>
 #include <opencog/atomspaceutils/AtomSpaceUtils.h>
 #include "Fitness.h"
@@ -82,10 +89,17 @@ public:
 	// FCS associated to the and-BIT
 	Handle fcs;
 
-	// Mapping from the FCS leaves to BITNodes
-	typedef std::unordered_map<Handle, BITNode> HandleBITNodeMap;
+	// Mapping from the FCS leaves to BITNodes. The BITNodes are
+	// allocated in bitnode_slab and owned by the and-BIT.
+	typedef std::unordered_map<Handle, BITNode*> HandleBITNodeMap;
 	HandleBITNodeMap leaf2bitnode;
 
+	// Slab the BITNodes are allocated from, shared by the and-BITs
+	// of a BIT, or by an and-BIT created outside of a BIT and its
+	// expansions.
+	typedef std::shared_ptr<Slab<BITNode>> BITNodeSlabPtr;
+	BITNodeSlabPtr bitnode_slab;
+
 	// The complexity of an and-BIT is the sum of the complexities of
 	// the steps involved in producing it. More specifically the steps
 	// of choosing the BIT-leaf to expand from and the rule to expand
@@ -98,24 +112,45 @@ public:
 	// Queried atomspace
 	const AtomSpace* queried_as;
 
+	// Position in BIT::andbits, maintained by the BIT
+	size_t index;
+
 	/**
 	 * @brief Initialize an and-BIT with a certain target, vardecl and
 	 * fitness and add it in bit_as. If an extra atomspace queried_as
 	 * is provided, then subsequent and-BITs produced from it will
 	 * have their constants removed if present in the queried
-	 * atomspace.
+	 * atomspace. Its BIT-nodes are allocated in the given slab, or in
+	 * a slab of its own if none is provided.
 	 */
 	AndBIT();
 	AndBIT(AtomSpace& bit_as, const Handle& target, Handle vardecl,
 	       const BITNodeFitness& fitness=BITNodeFitness(),
-	       const AtomSpace* queried_as=nullptr);
+	       const AtomSpace* queried_as=nullptr,
+	       BITNodeSlabPtr bitnode_slab=nullptr);
 	/**
 	 * @brief construct a and-BIT given its FCS and complexity.
 	 */
 	AndBIT(const Handle& fcs, double complexity=0.0,
-	       const AtomSpace* queried_as=nullptr);
+	       const AtomSpace* queried_as=nullptr,
+	       BITNodeSlabPtr bitnode_slab=nullptr);
 	~AndBIT();
 
+	/**
+	 * Copying an and-BIT copies its BIT-nodes in the same
+	 * slab. Moving an and-BIT moves its leaf2bitnode map without
+	 * copying it, the BIT-nodes keeping their addresses.
+	 */
+	AndBIT(const AndBIT&);
+	AndBIT(AndBIT&&);
+	AndBIT& operator=(const AndBIT&);
+	AndBIT& operator=(AndBIT&&);
+
+	/**
+	 * Move the BIT-nodes into the given slab.
+	 */
+	void set_bitnode_slab(BITNodeSlabPtr slab);
+
 	/**
 	 * @brief Expand the and-BIT given a target leaf and rule.
 	 *
@@ -288,6 +323,13 @@ private:
 	HandleBITNodeMap::iterator
 	insert_bitnode(Handle leaf, const BITNodeFitness& fitness);
 
+	/**
+	 * Copy the BIT-nodes of other into bitnode_slab, and destroy
+	 * them, respectively.
+	 */
+	void copy_bitnodes(const HandleBITNodeMap& other);
+	void destroy_bitnodes();
+
 	/**
 	 * Return all the leaves (or blanket because these new target
 	 * leaves cover the previous intermediary targets), of an
@@ -416,11 +458,13 @@ public:
 	// Child atomspace of the queried atomspace for storing the BIT
 	AtomSpace bit_as;
 
-	// Collection of and-BITs. We use a sorted vector instead of a set
-	// because the andbit being expanded is modified (its expanded
-	// bit-Node keeps track of the expansion). Alternatively we could
-	// use a set and define AndBIT::leaf2bitnode as mutable.
-	typedef std::vector<AndBIT> AndBITs;
+	// Collection of and-BITs. The and-BITs are allocated in
+	// _andbit_slab, andbits only holds pointers to them, so they are
+	// never moved nor copied once inserted, and pointers and
+	// references to them, or to their BIT-nodes, remain valid till
+	// they are erased. Their order however changes on erasure.
+	// Duplicates are detected using _fcs_index.
+	typedef boost::ptr_vector<AndBIT, boost::view_clone_allocator> AndBITs;
 	AndBITs andbits;
 
 	/**
@@ -458,30 +502,87 @@ public:
 	               const RuleTypedSubstitutionPair& rule,
 	               double prob=1.0);
 
+	/**
+	 * Like expand but return the expansion instead of inserting it in
+	 * the BIT, with a null FCS if it has failed. Only andbit and
+	 * bitleaf are accessed, so that it may run concurrently with
+	 * other expansions as long as they involve different and-BITs.
+	 */
+	AndBIT expansion(AndBIT& andbit, BITNode& bitleaf,
+	                 const RuleTypedSubstitutionPair& rule,
+	                 double prob=1.0) const;
+
 	/**
 	 * Insert a new andbit in the BIT and return its pointer, nullptr
 	 * if not inserted (which may happen if an equivalent one is
-	 * already in it). Warning: the reference on andbit will likely be
-	 * invalid after this call because the container is modified.
+	 * already in it). Amortized constant time. The pointers to the
+	 * and-BITs already in the BIT remain valid after this call.
+	 */
+	AndBIT* insert(const AndBIT& andbit);
+
+	/**
+	 * Like above but move andbit into the BIT if inserted.
 	 */
-	AndBIT* insert(AndBIT& andbit);
+	AndBIT* insert(AndBIT&& andbit);
 
 	/**
-	 * Erase the given and-BIT from the BIT and remove its FCS from
-	 * bit_as.
+	 * Return the and-BIT with the given FCS, nullptr if none.
+	 */
+	AndBIT* find(const Handle& fcs) const;
+
+	/**
+	 * Erase the given and-BIT from the BIT, remove its FCS from
+	 * bit_as and release its storage. The last and-BIT is moved in
+	 * its place, the returned iterator points to it.
 	 */
 	template<typename It> AndBITs::iterator erase(It pos);
 
+	/**
+	 * Erase the given and-BITs from the BIT, remove their FCSs from
+	 * bit_as and release their storage, in a single pass over
+	 * andbits. The remaining and-BITs keep their relative order.
+	 */
+	void erase(const std::vector<AndBIT*>& victims);
+
+	/**
+	 * Set the and-BIT exhausted flag to true.
+	 */
+	void set_exhausted(AndBIT& andbit);
+
 	/**
 	 * Reset to false all and-BITs exhausted flags.
 	 */
 	void reset_exhausted_flags();
 
 	/**
-	 * Return true if all andbits are exhausted.
+	 * Return true if all andbits are exhausted. Constant time.
 	 */
 	bool andbits_exhausted() const;
 
+	/**
+	 * Set the function calculating the weight of an and-BIT, used to
+	 * sample and-BITs. Weights are cached, and only recalculated when
+	 * an and-BIT is inserted, or its exhausted flag is set or
+	 * reset. Thus the function must only depend on the and-BIT FCS,
+	 * complexity and exhausted flag. By default the weight is 1, or 0
+	 * if exhausted.
+	 */
+	typedef std::function<double(const AndBIT&)> AndBITWeight;
+	void set_andbit_weight(const AndBITWeight& weight);
+
+	/**
+	 * Return the cached weight of an and-BIT, and the sum of the
+	 * weights of all and-BITs.
+	 */
+	double get_weight(const AndBIT& andbit) const;
+	double total_weight() const;
+
+	/**
+	 * Sample an and-BIT with probability proportional to its weight,
+	 * in logarithmic time. Return nullptr if all weights are null.
+	 */
+	AndBIT* sample();
+
 	/**
 	 * Return true if the rule is already an or-children of bitnode up
 	 * to an alpha conversion.
@@ -493,6 +594,41 @@ private:
 	// Queried atomspace
 	AtomSpace* _as;
 
+	// Hold the BIT-nodes of the and-BITs of the BIT. Shared with the
+	// and-BITs, so that and-BITs copied out of the BIT remain valid.
+	AndBIT::BITNodeSlabPtr _bitnode_slab;
+
+	// Hold the and-BITs pointed by andbits. All are destroyed in bulk
+	// with the BIT.
+	Slab<AndBIT> _andbit_slab;
+
+	// Calculate the and-BIT weights, see set_andbit_weight
+	AndBITWeight _andbit_weight;
+
+	// Cached weights of the and-BITs, the weight of andbits[i] at
+	// index i.
+	SumTree _sampler;
+
+	// Number of exhausted and-BITs
+	size_t _exhausted_count;
+
+	// Return true, and log it, if an and-BIT with the same FCS is
+	// already in the BIT.
+	bool is_duplicate(const AndBIT& andbit) const;
+
+	// Append the given and-BIT, allocated in _andbit_slab, to andbits,
+	// index it and weight it.
+	AndBIT* add(AndBIT* andbit);
+
+	// Remove the given and-BIT from andbits, moving the last and-BIT
+	// in its place, and from the indexes, then destroy it. Return its
+	// former position.
+	size_t remove(AndBIT* andbit);
+
+	// Map each FCS to its and-BIT in andbits. As FCSs are atoms in
+	// bit_as, hashing them amounts to hashing their content.
+	std::unordered_map<Handle, AndBIT*> _fcs_index;
+
 	Handle _init_target;
 	Handle _init_vardecl;
 	BITNodeFitness _init_fitness;
@@ -501,8 +637,9 @@ private:
 template<typename It>
 BIT::AndBITs::iterator BIT::erase(It pos)
 {
-	remove_hypergraph(bit_as, pos->fcs);
-	return andbits.erase(pos);
+	AndBIT* andbit = &*pos;
+	remove_hypergraph(bit_as, andbit->fcs);
+	return std::next(andbits.begin(), remove(andbit));
 }
 
 // Gdb debugging, see
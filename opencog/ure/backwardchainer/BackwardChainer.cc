@@ -23,12 +23,20 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <tuple>
+
 #include <opencog/util/random.h>
 
 #include <opencog/unify/Unify.h>
 
 #include "BackwardChainer.h"
 #include "../URELogger.h"
+#include "../URERandGen.h"
+#include "../RuleImplicator.h"
 
 using namespace opencog;
 
@@ -46,6 +54,7 @@ BackwardChainer::BackwardChainer(AtomSpace& kb_as,
                                  const AndBITFitness& andbit_fitness)
 	: _kb_as(kb_as),
 	  _rb_as(rb_as),
+	  _scratch_as_pool(&kb_as),
 	  _config(_rb_as, rbs),
 	  _bit(kb_as, target, vardecl, bitnode_fitness),
 	  _andbit_fitness(andbit_fitness),
@@ -53,10 +62,16 @@ BackwardChainer::BackwardChainer(AtomSpace& kb_as,
 	  _control(_config, _bit, target, control_as),
 	  _rules(_control.rules),
 	  _iteration(0),
-	  _last_expansion_andbit(nullptr)
+	  _start_time(std::chrono::steady_clock::now()),
+	  _start_kb_size(kb_as.get_size()),
+	  _meta_expanded(false)
 {
 	// Record the target in the trace atomspace
 	_trace_recorder.target(target);
+
+	// Weight and-BITs for expansion
+	_bit.set_andbit_weight([this](const AndBIT& andbit) {
+			return operator()(andbit); });
 }
 
 BackwardChainer::BackwardChainer(AtomSpace& kb_as,
@@ -85,29 +100,114 @@ const UREConfig& BackwardChainer::get_config() const
 	return _config;
 }
 
-void BackwardChainer::do_chain()
+size_t BackwardChainer::scratch_atomspaces_allocated() const
+{
+	return _scratch_as_pool.allocated()
+		+ _control.scratch_atomspaces_allocated();
+}
+
+void BackwardChainer::do_chain(const CancellationTokenPtr& token)
 {
+	// Use the given token, if any, for that chaining only
+	ScopedCancellationToken scoped_token(_token, token);
+
 	ure_logger().debug("Start backward chaining");
 	LAZY_URE_LOG_DEBUG << "With rule set:" << std::endl << oc_to_string(_rules);
 
-	while (not termination())
+	// Record the start of the chaining to check the budgets
+	_start_time = std::chrono::steady_clock::now();
+	_start_kb_size = _kb_as.get_size();
+
+	// Seed the random generator of the calling thread
+	std::unique_ptr<ScopedRandGen> randgen;
+	if (0 <= _config.get_random_seed())
+		randgen.reset(new ScopedRandGen(_config.get_random_seed()));
+
+	if (_config.get_jobs() <= 1)
+	{
+		// Do steps single-threadedly till termination
+		while (not termination())
+			do_step();
+	} else
 	{
-		do_step();
+		// Set log thread ID if multi-threaded
+		bool prev_thread_id = ure_logger().get_thread_id_flag();
+		ure_logger().set_thread_id_flag(true);
+
+		// Do steps multi-threadedly till termination
+		do_steps_multithread();
+
+		// Restore logging thread ID flag
+		ure_logger().set_thread_id_flag(prev_thread_id);
 	}
 
 	LAZY_URE_LOG_DEBUG << "Finished backward chaining with results:"
 	                   << std::endl << oc_to_string(get_results_set());
 }
 
+void BackwardChainer::do_steps_multithread()
+{
+	unsigned jobs = _config.get_jobs();
+	_pool.reserve(jobs);
+
+	// Each worker keeps claiming and running iterations till
+	// termination, drawing from its own random stream if seeded
+	int seed = _config.get_random_seed();
+	for (unsigned i = 0; i < jobs; i++)
+		_pool.push([this, i, seed]() {
+				std::unique_ptr<ScopedRandGen> randgen;
+				if (0 <= seed)
+					randgen.reset(new ScopedRandGen(derive_seed(seed, i)));
+				int iteration;
+				while (claim_iteration(iteration))
+					do_step(iteration);
+			});
+
+	// Wait for all workers to be done
+	_pool.wait();
+}
+
+bool BackwardChainer::claim_iteration(int& iteration)
+{
+	if (termination())
+		return false;
+
+	// Atomically increment the iteration counter, making sure it does
+	// not go beyond the maximum number of iterations if another
+	// worker has claimed it in the meantime.
+	int max_iter = _config.get_maximum_iterations();
+	int previous = _iteration;
+	do {
+		if (0 <= max_iter and max_iter <= previous)
+			return false;
+	} while (not _iteration.compare_exchange_weak(previous, previous + 1));
+	iteration = previous + 1;
+	return true;
+}
+
 void BackwardChainer::do_step()
 {
-	_iteration++;
+	do_step(++_iteration);
+}
 
-	ure_logger().debug() << "Iteration " << _iteration
+void BackwardChainer::do_step(int iteration)
+{
+	ure_logger().debug() << "Iteration " << iteration
 	                     << "/" << _config.get_maximum_iterations_str();
 
-	expand_bit();
-	fulfill_bit();
+	AndBIT* andbit = expand_bit();
+
+	// Only check cancellation before fulfillment, which is where the
+	// pattern matcher may take long, so that the BIT remains
+	// consistent.
+	if (is_cancelled()) {
+		ure_logger().debug() << "Chaining cancelled, abort iteration";
+		release(andbit);
+		return;
+	}
+
+	fulfill_bit(andbit);
+	release(andbit);
 	reduce_bit();
 }
 
@@ -116,14 +216,36 @@ bool BackwardChainer::termination()
 	bool terminate = false;
 	std::string msg;            // Cause of the termination
 
-	if (_config.get_maximum_iterations() == _iteration) {
+	if (is_cancelled()) {
+		msg = "the chaining has been cancelled";
+		terminate = true;
+	}
+	else if (_config.get_maximum_iterations() == _iteration) {
 		msg = "reached the maximum number of iterations";
 		terminate = true;
 	}
-	else if (not _bit.empty() and _bit.andbits_exhausted()) {
+	else if (bit_exhausted()) {
 		msg = "all AndBITS are exhausted";
 		terminate = true;
 	}
+	else if (0 <= _config.get_maximum_time() and
+	         _config.get_maximum_time() <=
+	         std::chrono::duration<double>(std::chrono::steady_clock::now()
+	                                       - _start_time).count()) {
+		msg = "reached the maximum time";
+		terminate = true;
+	}
+	else if (0 <= _config.get_maximum_kb_additions() and
+	         _start_kb_size + _config.get_maximum_kb_additions()
+	         <= _kb_as.get_size()) {
+		msg = "reached the maximum number of atoms added to the knowledge base";
+		terminate = true;
+	}
+	else if (0 <= _config.get_maximum_population_size() and
+	         (size_t)_config.get_maximum_population_size() <= bit_size()) {
+		msg = "reached the maximum number of AndBITs";
+		terminate = true;
+	}
 
 	if (terminate)
 		ure_logger().debug() << "Terminate: " << msg;
@@ -131,27 +253,69 @@ bool BackwardChainer::termination()
 	return terminate;
 }
 
+bool BackwardChainer::is_cancelled() const
+{
+	CancellationTokenPtr token = std::atomic_load(&_token);
+	return token and token->is_cancelled();
+}
+
 Handle BackwardChainer::get_results() const
 {
+	std::unique_lock<std::mutex> lock(_results_mutex);
 	HandleSeq results(_results.begin(), _results.end());
+	lock.unlock();
 	return _kb_as.add_link(SET_LINK, std::move(results));
 }
 
-const HandleSet& BackwardChainer::get_results_set() const
+HandleSet BackwardChainer::get_results_set() const
 {
+	std::lock_guard<std::mutex> lock(_results_mutex);
 	return _results;
 }
 
+bool BackwardChainer::bit_exhausted() const
+{
+	std::lock_guard<std::mutex> lock(_bit_mutex);
+	return not _bit.empty() and _bit.andbits_exhausted();
+}
+
+size_t BackwardChainer::bit_size() const
+{
+	std::lock_guard<std::mutex> lock(_bit_mutex);
+	return _bit.size();
+}
+
 void BackwardChainer::expand_meta_rules()
 {
+	// Meta rules are run over the whole knowledge base the first
+	// time, then only over the results added since the previous
+	// expansion.
+	HandleSet new_results;
+	{
+		std::lock_guard<std::mutex> lock(_results_mutex);
+		new_results.swap(_meta_new_results);
+	}
+	if (_meta_expanded and new_results.empty())
+		return;
+
+	// The rule set is modified, so wait for the expansions in
+	// progress, which select rules from it, to be done.
+	std::unique_lock<std::shared_timed_mutex> rules_lock(_control.rules_mutex);
+
 	// This is kinda of hack before meta rules are fully supported by
 	// the Rule class.
 	size_t rules_size = _rules.size();
-	_rules.expand_meta_rules(_kb_as);
+	if (not _meta_expanded) {
+		_rules.expand_meta_rules(_kb_as);
+		_meta_expanded = true;
+	} else {
+		_rules.expand_meta_rules(_kb_as, new_results, _scratch_as_pool);
+	}
 
 	// If the rule set has changed we need to reset the exhausted
 	// flags.
 	if (rules_size != _rules.size()) {
+		std::lock_guard<std::mutex> lock(_bit_mutex);
 		_bit.reset_exhausted_flags();
 		ure_logger().debug() << "The rule set has gone from "
 		                     << rules_size << " rules to " << _rules.size()
@@ -159,29 +323,52 @@ void BackwardChainer::expand_meta_rules()
 	}
 }
 
-void BackwardChainer::expand_bit()
+AndBIT* BackwardChainer::expand_bit()
 {
 	// Expand meta rules, before they are fully supported
 	expand_meta_rules();
 
-	// Reset _last_expansion_fcs
-	_last_expansion_andbit = nullptr;
-
+	std::unique_lock<std::mutex> lock(_bit_mutex);
 	if (_bit.empty()) {
-		_last_expansion_andbit = _bit.init();
+		AndBIT* andbit = _bit.init();
+		_in_flight.insert(andbit->fcs);
+		lock.unlock();
 		// Record the initial and-BIT in the trace atomspace
-		_trace_recorder.andbit(*_last_expansion_andbit);
-	} else {
-		// Select an FCS (i.e. and-BIT) and expand it
-		AndBIT* andbit = select_expansion_andbit();
-		LAZY_URE_LOG_DEBUG << "Selected and-BIT for expansion:" << std::endl
-		                   << andbit->to_string();
-		expand_bit(*andbit);
+		_trace_recorder.andbit(*andbit);
+		return andbit;
+	}
+
+	// Select an FCS (i.e. and-BIT) and expand it
+	AndBIT* andbit = select_expansion_andbit();
+	if (not andbit) {
+		ure_logger().debug() << "All and-BITs have null weight. "
+		                     << "Abort expansion.";
+		return nullptr;
+	}
+
+	// Claim it, so that it is neither expanded by other threads
+	// meanwhile, nor removed from the BIT
+	if (not _in_flight.insert(andbit->fcs).second) {
+		ure_logger().debug() << "The selected and-BIT is being expanded "
+		                     << "or fulfilled in another thread. "
+		                     << "Abort expansion.";
+		return nullptr;
 	}
+	lock.unlock();
+	LAZY_URE_LOG_DEBUG << "Selected and-BIT for expansion:" << std::endl
+	                   << andbit->to_string();
+
+	AndBIT* new_andbit = expand_bit(*andbit);
+	release(andbit);
+	return new_andbit;
 }
 
-void BackwardChainer::expand_bit(AndBIT& andbit)
+AndBIT* BackwardChainer::expand_bit(AndBIT& andbit)
 {
+	// Hold the rule set while selecting a rule from it, and while the
+	// BIT-nodes exhausted flags may be updated, see expand_meta_rules
+	std::shared_lock<std::shared_timed_mutex> rules_lock(_control.rules_mutex);
+
 	// Select leaf
 	BITNode* bitleaf = andbit.select_leaf();
 	if (bitleaf) {
@@ -190,8 +377,9 @@ void BackwardChainer::expand_bit(AndBIT& andbit)
 	} else {
 		ure_logger().debug() << "All BIT-nodes of this and-BIT are exhausted "
 		                     << "(or possibly fulfilled). Abort expansion.";
-		andbit.exhausted = true;
-		return;
+		std::lock_guard<std::mutex> lock(_bit_mutex);
+		_bit.set_exhausted(andbit);
+		return nullptr;
 	}
 
 	// Select rule for expansion
@@ -208,44 +396,45 @@ void BackwardChainer::expand_bit(AndBIT& andbit)
 	if (not rule.is_valid()) {
 		ure_logger().debug("No valid rule for the selected BIT-node, "
 		                   "abort expansion");
-		return;
+		return nullptr;
 	} else if (rule.has_cycle()) {
 		LAZY_URE_LOG_DEBUG << "The following rule has cycle (some premise "
 		                   << "equals to conclusion), abort expansion:"
 		                   << std::endl << rule.to_string();
-		return;
+		return nullptr;
 	}
 
 	// Rule seems well, expand
 	LAZY_URE_LOG_DEBUG << "Selected rule, with probability " << prob
 	                   << " of success:" << std::endl << rule.to_string();
 
-	// Expand andbit. Warning: after this call the reference on andbit
-	// and bitleaf may no longer be valid because the container of
-	// and-BITs might have been resorted. so we keep track of their
-	// bodies for future use.
-	Handle andbit_fcs = andbit.fcs;
-	Handle bitleaf_body = bitleaf->body;
+	// Expand andbit, which only involves the claimed andbit, then
+	// insert the expansion in the BIT and claim it till fulfilled.
+	// And-BITs are never moved once in the BIT, so andbit and bitleaf
+	// remain valid after this call.
 	RuleTypedSubstitutionPair rtsp{rule, ts};
-	_last_expansion_andbit = _bit.expand(andbit, *bitleaf, rtsp, prob);
+	AndBIT expansion = _bit.expansion(andbit, *bitleaf, rtsp, prob);
+	if (not expansion.fcs)
+		return nullptr;
+	AndBIT* new_andbit;
+	{
+		std::lock_guard<std::mutex> lock(_bit_mutex);
+		new_andbit = _bit.insert(std::move(expansion));
+		if (new_andbit)
+			_in_flight.insert(new_andbit->fcs);
+	}
 
 	// Record the expansion in the trace atomspace
-	if (_last_expansion_andbit) {
-		_trace_recorder.andbit(*_last_expansion_andbit);
-		_trace_recorder.expansion(andbit_fcs, bitleaf_body,
-		                          rule, *_last_expansion_andbit);
+	if (new_andbit) {
+		_trace_recorder.andbit(*new_andbit);
+		_trace_recorder.expansion(andbit.fcs, bitleaf->body,
+		                          rule, *new_andbit);
 	}
+	return new_andbit;
 }
 
-void BackwardChainer::fulfill_bit()
+void BackwardChainer::fulfill_bit(const AndBIT* andbit)
 {
-	if (_bit.empty()) {
-		ure_logger().warn("Cannot fulfill an empty BIT!");
-		return;
-	}
-
-	// Select an and-BIT for fulfillment
-	const AndBIT* andbit = select_fulfillment_andbit();
 	if (andbit == nullptr) {
 		ure_logger().debug() << "Cannot fulfill an empty and-BIT. "
 		                    << "Abort BIT fulfillment";
@@ -261,11 +450,19 @@ void BackwardChainer::fulfill_bit()
 	} catch (...) {}
 }
 
+void BackwardChainer::release(const AndBIT* andbit)
+{
+	if (not andbit)
+		return;
+	std::lock_guard<std::mutex> lock(_bit_mutex);
+	_in_flight.erase(andbit->fcs);
+}
+
 void BackwardChainer::fulfill_fcs(const Handle& fcs)
 {
 	// Temporary atomspace to not pollute _as with intermediary
 	// results
-	AtomSpace tmp_as(&_kb_as);
+	AtomSpacePool::Lease tmp_as = _scratch_as_pool.borrow();
 
 	// Run the FCS and add the results, if any, in _as.
 	//
@@ -281,106 +478,198 @@ void BackwardChainer::fulfill_fcs(const Handle& fcs)
 	//
 	// TODO: Maybe we could take advantage of the new read-only
 	// capabilities of the AtomSpace.
-	Handle hresult = HandleCast(fcs->execute(&tmp_as));
+	//
+	// If the chaining is cancelled meanwhile, the FCS stops at its
+	// next grounding, keeping the results found so far.
+	RuleImplicator impl(tmp_as.get());
+	impl.token = std::atomic_load(&_token);
 	HandleSeq results;
-	for (const Handle& result : hresult->getOutgoingSet())
+	for (const Handle& result : impl.execute(fcs))
 		results.push_back(_kb_as.add_atom(result));
 	LAZY_URE_LOG_DEBUG << "Results:" << std::endl << results;
-	_results.insert(results.begin(), results.end());
+	{
+		std::lock_guard<std::mutex> lock(_results_mutex);
+		_results.insert(results.begin(), results.end());
+		_meta_new_results.insert(results.begin(), results.end());
+	}
 
 	// Record the results in _trace_as
 	for (const Handle& result : results)
 		_trace_recorder.proof(fcs, result);
 }
 
-std::vector<double> BackwardChainer::expansion_andbit_weights()
+bool BackwardChainer::is_in_flight(const Handle& fcs) const
 {
-	std::vector<double> weights;
-	for (const AndBIT& andbit : _bit.andbits)
-		weights.push_back(operator()(andbit));
-	return weights;
+	return _in_flight.find(fcs) != _in_flight.end();
 }
 
 AndBIT* BackwardChainer::select_expansion_andbit()
 {
-	std::vector<double> weights = expansion_andbit_weights();
-
 	// Debug log
 	if (ure_logger().is_debug_enabled()) {
-		OC_ASSERT(weights.size() == _bit.andbits.size());
 		std::stringstream ss;
 		ss << "Weighted and-BITs:";
-		for (size_t i = 0; i < weights.size(); i++)
-			ss << std::endl << weights[i] << " "
-			   << _bit.andbits[i].fcs->id_to_string();
+		for (const AndBIT& andbit : _bit.andbits)
+			ss << std::endl << _bit.get_weight(andbit) << " "
+			   << andbit.fcs->id_to_string();
 		ure_logger().debug() << ss.str();
 	}
 
-	// Sample andbits according to this distribution
-	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	return &rand_element(_bit.andbits, dist);
-}
-
-const AndBIT* BackwardChainer::select_fulfillment_andbit() const
-{
-	return _last_expansion_andbit;
+	// Sample andbits according to their cached weights
+	return _bit.sample();
 }
 
 void BackwardChainer::reduce_bit()
 {
-	if (0 < _config.get_max_bit_size()) {
+	std::lock_guard<std::mutex> lock(_bit_mutex);
+	double max_size = _config.get_max_bit_size();
+	if (0 < max_size and max_size < _bit.size()) {
 		// If the BIT size has reached its maximum, randomly remove
 		// and-BITs so that the BIT size gets back below or equal to
-		// its maximum.
-		while (_config.get_max_bit_size() < _bit.size()) {
-			// Randomly select an and-BIT that is unlikely to be used
-			// for the remaining of the inferenceThe and-BITs to remove are
-			// selected so that the least likely and-BITs to be
-			// selected for expansion are removed first.
-			remove_unlikely_expandable_andbit();
+		// its maximum. The and-BITs to remove are selected so that
+		// the least likely and-BITs to be selected for expansion are
+		// removed first. A single and-BIT, the usual case after an
+		// expansion, is usually picked up in constant time, several
+		// and-BITs are picked up and removed at once.
+		size_t excess = _bit.size() - (size_t)max_size;
+		size_t removed = excess == 1 ?
+			(size_t)remove_unlikely_expandable_andbit() :
+			remove_unlikely_expandable_andbits(excess);
+		if (removed < excess)
+			ure_logger().debug() << "Remaining and-BITs are being "
+			                     << "expanded or fulfilled, postpone reduction";
+	}
+}
+
+bool BackwardChainer::remove_unlikely_expandable_andbit()
+{
+	// Calculate the probability of never being expanded for the
+	// remainder of the inference, see never_expand_probs.
+	//
+	// When that probability is bounded by 1, the and-BIT is first
+	// sampled by rejection: and-BITs are proposed uniformly and
+	// accepted with their probability of never being expanded, in
+	// constant time per trial. If all trials fail, which is likely
+	// when most and-BITs are to be expanded, it falls back to
+	// calculating the distribution over all and-BITs.
+	double remaining_iterations = _config.get_maximum_iterations() - _iteration;
+	if (0 <= remaining_iterations) {
+		std::uniform_int_distribution<size_t> uniform(0, _bit.size() - 1);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		for (unsigned trial = 0; trial < 64; trial++) {
+			AndBIT& andbit = _bit.andbits[uniform(ure_randgen())];
+			double nep = never_expand_prob(andbit, remaining_iterations);
+			if (unit(ure_randgen()) < nep and not is_in_flight(andbit.fcs)) {
+				remove_andbit(andbit);
+				return true;
+			}
 		}
 	}
+
+	std::vector<bool> removable;
+	std::vector<double> neps = never_expand_probs(removable);
+	if (std::none_of(removable.begin(), removable.end(),
+	                 [](bool r) { return r; }))
+		return false;
+
+	// If all removable and-BITs are certain to be expanded, pick
+	// amongst them uniformly rather than amongst the ones in flight.
+	if (std::accumulate(neps.begin(), neps.end(), 0.0) <= 0.0)
+		for (size_t i = 0; i < removable.size(); i++)
+			neps[i] = removable[i] ? 1.0 : 0.0;
+
+	std::discrete_distribution<size_t> never_expand_dist(neps.begin(),
+	                                                     neps.end());
+	remove_andbit(_bit.andbits[never_expand_dist(ure_randgen())]);
+	return true;
 }
 
-void BackwardChainer::remove_unlikely_expandable_andbit()
+size_t BackwardChainer::remove_unlikely_expandable_andbits(size_t n)
 {
-	std::vector<double> weights = expansion_andbit_weights();
-	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	std::vector<double> never_expand_probs;
+	std::vector<bool> removable;
+	std::vector<double> neps = never_expand_probs(removable);
+
+	// Sample n and-BITs without replacement, with probability
+	// proportional to their never expand probabilities, by keeping
+	// the n greatest keys log(u)/p, u being uniform over [0, 1)
+	// (Efraimidis and Spirakis). Removable and-BITs with null
+	// probability come after, in random order.
+	typedef std::tuple<bool, double, size_t> Key;
+	std::vector<Key> keys;
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	for (size_t i = 0; i < neps.size(); i++) {
+		if (not removable[i])
+			continue;
+		double u = unit(ure_randgen());
+		if (0.0 < neps[i])
+			keys.emplace_back(true, std::log(u) / neps[i], i);
+		else
+			keys.emplace_back(false, u, i);
+	}
+	n = std::min(n, keys.size());
+	std::nth_element(keys.begin(), std::next(keys.begin(), n), keys.end(),
+	                 std::greater<Key>());
+
+	std::vector<AndBIT*> victims;
+	for (size_t k = 0; k < n; k++) {
+		AndBIT& andbit = _bit.andbits[std::get<2>(keys[k])];
+		LAZY_URE_LOG_DEBUG << "Remove " << andbit.fcs->id_to_string()
+		                   << " from the BIT";
+		victims.push_back(&andbit);
+	}
+	_bit.erase(victims);
+	return n;
+}
 
+std::vector<double>
+BackwardChainer::never_expand_probs(std::vector<bool>& removable)
+{
 	// Calculate the probability of never being expanded for the
 	// remainder of the inference, thus (1-p) raised to the power of
 	// _config.get_maximum_iterations() - _iteration. This makes
 	// the assumption that the BIT (i.e. its and-BIT population) is
 	// not gonna change from this point on, a false but OK assumption
 	// for now.
-	for (double p : dist.probabilities()) {
-		double remaining_iterations =
-			_config.get_maximum_iterations() - _iteration;
-		double nep = std::pow(1 - p, remaining_iterations);
-		never_expand_probs.push_back(nep);
+	//
+	// And-BITs being expanded or fulfilled are given a null
+	// probability so that they remain in the BIT.
+	double remaining_iterations = _config.get_maximum_iterations() - _iteration;
+	std::vector<double> neps;
+	removable.clear();
+	for (const AndBIT& andbit : _bit.andbits) {
+		removable.push_back(not is_in_flight(andbit.fcs));
+		neps.push_back(removable.back() ?
+		               never_expand_prob(andbit, remaining_iterations) : 0.0);
 	}
 
 	// Fine log
 	if (ure_logger().is_fine_enabled()) {
-		OC_ASSERT(never_expand_probs.size() == _bit.andbits.size());
 		std::stringstream ss;
 		ss << "Never expand probs and-BITs:";
-		for (size_t i = 0; i < never_expand_probs.size(); i++)
-			ss << std::endl << never_expand_probs[i] << " "
+		for (size_t i = 0; i < neps.size(); i++)
+			ss << std::endl << neps[i] << " "
 			   << _bit.andbits[i].fcs->id_to_string();
 		ure_logger().fine() << ss.str();
 	}
 
-	std::discrete_distribution<size_t>
-		never_expand_dist(never_expand_probs.begin(), never_expand_probs.end());
+	return neps;
+}
 
-	// Pick the and-BIT, remove it from the BIT and remove its
-	// FCS from the bit atomspace.
-	auto it = std::next(_bit.andbits.begin(), never_expand_dist(randGen()));
-	LAZY_URE_LOG_DEBUG << "Remove " << it->fcs->id_to_string()
+double BackwardChainer::never_expand_prob(const AndBIT& andbit,
+                                          double remaining_iterations) const
+{
+	double total = _bit.total_weight();
+	double p = 0.0 < total ? _bit.get_weight(andbit) / total : 0.0;
+	return std::pow(1 - p, remaining_iterations);
+}
+
+void BackwardChainer::remove_andbit(AndBIT& andbit)
+{
+	// Remove the and-BIT from the BIT and its FCS from the bit
+	// atomspace.
+	LAZY_URE_LOG_DEBUG << "Remove " << andbit.fcs->id_to_string()
 	                   << " from the BIT";
-	_bit.erase(it);
+	_bit.erase(std::next(_bit.andbits.begin(), andbit.index));
 }
 
 double BackwardChainer::complexity_factor(const AndBIT& andbit) const
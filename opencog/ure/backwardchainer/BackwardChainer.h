@@ -25,8 +25,14 @@
 #ifndef _OPENCOG_BACKWARDCHAINER_H_
 #define _OPENCOG_BACKWARDCHAINER_H_
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
 #include "../Rule.h"
 #include "../UREConfig.h"
+#include "../CancellationToken.h"
+#include "../ThreadPool.h"
 #include "BIT.h"
 #include "TraceRecorder.h"
 #include "ControlPolicy.h"
@@ -144,11 +150,28 @@ public:
 	UREConfig& get_config();
 	const UREConfig& get_config() const;
 
+	/**
+	 * Number of scratch atomspaces allocated so far to fulfill
+	 * and-BITs and to match control rules. As they are reused, it is
+	 * bounded by the number of simultaneous fulfillments, not the
+	 * number of iterations.
+	 */
+	size_t scratch_atomspaces_allocated() const;
+
 	/**
 	 * Perform backward chaining inference till the termination
-	 * criteria have been met.
+	 * criteria have been met, or the given token, if any, has been
+	 * cancelled. Fulfillments in progress then stop at their next
+	 * grounding, keeping the results found so far. The token is only
+	 * used for that chaining.
+	 *
+	 * If the jobs parameter is greater than 1, steps are run in
+	 * parallel on a pool of jobs workers, each expanding and
+	 * fulfilling its own and-BIT. An and-BIT being expanded or
+	 * fulfilled by a worker is neither expanded by another, nor
+	 * removed from the BIT, the iteration is then skipped instead.
 	 */
-	void do_chain();
+	void do_chain(const CancellationTokenPtr& token=nullptr);
 
 	/**
 	 * Perform a single backward chaining inference step.
@@ -159,8 +182,11 @@ public:
 	 * @return true if the termination criteria have been met.
 	 *
 	 * More specifically, either
+	 * 0. the token passed to do_chain has been cancelled,
 	 * 1. reached the maximum number of iterations,
-	 * 2. or all andbits are exhausted.
+	 * 2. all andbits are exhausted,
+	 * 3. or some budget (time, knowledge base additions, BIT size)
+	 *    has been exceeded.
 	 */
 	bool termination();
 
@@ -169,50 +195,97 @@ public:
 	 * all inferred atoms matching the target.
 	 */
 	Handle get_results() const;
-	const HandleSet& get_results_set() const;
+
+	/**
+	 * Like above but return a copy of the result set, so that it may
+	 * be called while fulfillments are in progress.
+	 */
+	HandleSet get_results_set() const;
 
 private:
+	// Perform a step given its iteration number
+	void do_step(int iteration);
+
+	// Run do_step over jobs workers till termination
+	void do_steps_multithread();
+
+	// Claim the next iteration, if the termination criteria have not
+	// been met, and store it in iteration. Return false otherwise.
+	bool claim_iteration(int& iteration);
+
+	// Like _bit.andbits_exhausted() and _bit.size(), but guarded
+	bool bit_exhausted() const;
+	size_t bit_size() const;
+
+	// Return true iff the token passed to do_chain has been cancelled
+	bool is_cancelled() const;
+
 	void expand_meta_rules();
 
-	// Expand the BIT
-	void expand_bit();
+	// Expand the BIT. Return the new and-BIT, claimed by the caller
+	// till released, nullptr if the expansion has failed.
+	AndBIT* expand_bit();
+
+	// Expand a selected and-BIT, claimed by the caller. It is not
+	// passed by const because it will keep a record of the expansion
+	// if successful. Return the new and-BIT, claimed as well.
+	AndBIT* expand_bit(AndBIT& andbit);
 
-	// Expand a selected and-BIT. It is not passed by const because it
-	// will keep a record of the expansion if successful.
-	void expand_bit(AndBIT& andbit);
+	// Fulfill an and-BIT returned by expand_bit, if any
+	void fulfill_bit(const AndBIT* andbit);
 
-	// Fulfill the BIT. That is run some or all its and-BITs
-	void fulfill_bit();
+	// Release an and-BIT claimed by expand_bit, if any
+	void release(const AndBIT* andbit);
 
 	// Fulfill an FCS (i.e and-BIT). That is run its forward chaining
-	// strategy.
+	// strategy. Thread safe.
 	void fulfill_fcs(const Handle& fcs);
 
+	// Return true iff the and-BIT of fcs is being expanded or
+	// fulfilled. _bit_mutex must be held.
+	bool is_in_flight(const Handle& fcs) const;
+
 	// Reduce the BIT. Remove some and-BITs.
 	void reduce_bit();
 
 	// Pick up an and-BIT randomly, biased so that this and-BIT is
 	// unlikely to be expanded for the remainder of the inference.
-	void remove_unlikely_expandable_andbit();
-
-	// Calculate distribution based on a (poor) estimate of the
-	// probablity of a and-BIT being within the path of the solution.
-	std::vector<double> expansion_andbit_weights();
-
-	// Select an and-BIT for expansion
+	// And-BITs being expanded or fulfilled are never picked. Return
+	// false if no and-BIT could be removed.
+	bool remove_unlikely_expandable_andbit();
+
+	// Like above but pick up n distinct and-BITs at once, erasing
+	// them from the BIT in a single pass. Return the number of
+	// and-BITs removed, lower than n if too many are in flight.
+	size_t remove_unlikely_expandable_andbits(size_t n);
+
+	// Return the probabilities of the and-BITs of never being
+	// expanded for the remainder of the inference, null for the ones
+	// in flight. removable is filled with false for the latter,
+	// true for the others.
+	std::vector<double> never_expand_probs(std::vector<bool>& removable);
+
+	// Return the probability that an and-BIT is never expanded for
+	// the remaining iterations, given its cached weight.
+	double never_expand_prob(const AndBIT& andbit,
+	                         double remaining_iterations) const;
+
+	// Remove an and-BIT from the BIT
+	void remove_andbit(AndBIT& andbit);
+
+	// Select an and-BIT for expansion, according to the weights
+	// cached in the BIT, see operator(). Return nullptr if all
+	// weights are null.
 	AndBIT* select_expansion_andbit();
 
-	// Select an and-BIT for fulfilment. Return nullptr if none have
-	// been selected.
-	const AndBIT* select_fulfillment_andbit() const;
-
 	// Return the complexity factor of an andbit. The formula is
 	//
 	// exp(-complexity_penalty * andbit.complexity())
 	double complexity_factor(const AndBIT& andbit) const;
 
 	// Return an very crude estimate of the probability that expanding
-	// this and-BIT may lead to a successful inference.
+	// this and-BIT may lead to a successful inference. Used as weight
+	// of the and-BITs by the BIT, which caches it.
 	double operator()(const AndBIT& andbit) const;
 
 	// Atomspace containing the knowledge base and where the final
@@ -222,12 +295,22 @@ private:
 	// Atomspace containing the rule base, can be the same as _kb_as
 	AtomSpace& _rb_as;
 
+	// Scratch atomspaces, children of _kb_as, to hold the
+	// intermediary results of fulfillment.
+	AtomSpacePool _scratch_as_pool;
+
 	// Contain the configuration
 	UREConfig _config;
 
 	// Structure holding the Back Inference Tree
 	BIT _bit;
 
+	// Protect _bit, its and-BIT slab excepted, which is thread safe,
+	// and _in_flight. Once claimed, an and-BIT and its BIT-nodes are
+	// only accessed by the worker that has claimed it, so that this
+	// lock is not held while expanding or fulfilling it.
+	mutable std::mutex _bit_mutex;
+
 	// TODO: perhaps move that under BIT
 	AndBITFitness _andbit_fitness;
 
@@ -240,13 +323,43 @@ private:
 	// Reference to the control policy rule set
 	RuleSet& _rules;
 
-	int _iteration;
+	std::atomic<int> _iteration;
+
+	// Token passed to do_chain, if any, during that chaining.
+	// Accessed atomically, as fulfillments read it from the workers.
+	CancellationTokenPtr _token;
 
-	// Keep track of the and-BIT of the last expansion. Null if the
-	// last expansion has failed.
-	const AndBIT* _last_expansion_andbit;
+	// Start time and knowledge base size at the start of the
+	// chaining, to check the budgets.
+	std::chrono::steady_clock::time_point _start_time;
+	size_t _start_kb_size;
+
+	// Whether meta rules have been expanded over the whole knowledge
+	// base
+	std::atomic<bool> _meta_expanded;
 
 	HandleSet _results;
+
+	// Results added since the last expansion of meta rules
+	HandleSet _meta_new_results;
+
+	// Protect _results and _meta_new_results, which fulfillments may
+	// update concurrently
+	mutable std::mutex _results_mutex;
+
+	// FCSs whose and-BITs are being expanded or fulfilled, i.e.
+	// claimed by a worker. They are neither expanded by another
+	// worker, nor removed from the BIT, since that would remove their
+	// FCS from the BIT atomspace while being executed.
+	HandleSet _in_flight;
+
+	// Pool of workers running the steps when jobs > 1. The BIT is
+	// guarded by _bit_mutex, the rule set of the control policy by
+	// its rules_mutex, taken before _bit_mutex when both are needed.
+	//
+	// Declared last so that it is destroyed first, waiting for the
+	// steps in progress while the members they use are alive.
+	ThreadPool _pool;
 };
 
 
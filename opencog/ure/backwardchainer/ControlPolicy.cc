@@ -34,6 +34,7 @@
 
 #include "TraceRecorder.h"
 #include "../URELogger.h"
+#include "../URERandGen.h"
 
 using namespace opencog;
 
@@ -104,6 +105,11 @@ HandleSet ControlPolicy::rule_aliases(const RuleTypedSubstitutionMap& rules)
 	return aliases;
 }
 
+size_t ControlPolicy::scratch_atomspaces_allocated() const
+{
+	return _scratch_as_pool.allocated();
+}
+
 RuleTypedSubstitutionMap ControlPolicy::get_valid_rules(const AndBIT& andbit,
                                                         const BITNode& bitleaf)
 {
@@ -147,7 +153,7 @@ RuleSelection ControlPolicy::select_rule(const AndBIT& andbit,
 
 	// Sample an inference rule according to the distribution
 	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	const RuleTypedSubstitutionPair& selected_rule = rand_element(inf_rules, dist);
+	const RuleTypedSubstitutionPair& selected_rule = ure_rand_element(inf_rules, dist);
 
 	// Return the selected rule and its probability of success, will
 	// be used to calculate the TV that the produce and-BIT is a
@@ -171,8 +177,11 @@ HandleTVMap ControlPolicy::expansion_success_tvs(
 
 		if (active_ctrl_rules.empty()) {
 			// If there are no active control rules, use the default
-			// TV on the rule.
-			success_tvs[rule] = _default_tvs[rule];
+			// TV on the rule, if any. Looked up without insertion, as
+			// rules may be selected concurrently.
+			auto dtv = _default_tvs.find(rule);
+			success_tvs[rule] = dtv == _default_tvs.end() ?
+				TruthValuePtr() : dtv->second;
 		} else {
 			// Otherwise calculate the truth value of its mixture
 			// model.
@@ -246,7 +255,10 @@ HandleSet ControlPolicy::active_expansion_control_rules(
 
 	// Filter out inactive expansion control rules
 	HandleSet results;
-	for (const Handle& ctrl_rule : _expansion_control_rules[inf_rule_alias])
+	auto ecr = _expansion_control_rules.find(inf_rule_alias);
+	if (ecr == _expansion_control_rules.end())
+		return results;
+	for (const Handle& ctrl_rule : ecr->second)
 		if (is_control_rule_active(andbit, bitleaf, ctrl_rule))
 			results.insert(ctrl_rule);
 
@@ -317,12 +329,12 @@ bool ControlPolicy::is_control_rule_active(const AndBIT& andbit,
 bool ControlPolicy::match(const Handle& pattern, const Handle& term,
                           const Handle& vardecl) const
 {
-	AtomSpace tmp_as;
-	Handle rewrite = tmp_as.add_node(CONCEPT_NODE, "dummy"),
-		impl = tmp_as.add_link(IMPLICATION_SCOPE_LINK,
-		                       vardecl, pattern, rewrite),
-		tmp_term = tmp_as.add_atom(term),
-		result = HandleCast(MapLink(impl, tmp_term).execute(&tmp_as, false));
+	AtomSpacePool::Lease tmp_as = _scratch_as_pool.borrow();
+	Handle rewrite = tmp_as->add_node(CONCEPT_NODE, "dummy"),
+		impl = tmp_as->add_link(IMPLICATION_SCOPE_LINK,
+		                        vardecl, pattern, rewrite),
+		tmp_term = tmp_as->add_atom(term),
+		result = HandleCast(MapLink(impl, tmp_term).execute(tmp_as.get(), false));
 
 	return (bool)result;
 }
@@ -23,11 +23,14 @@
 #ifndef _OPENCOG_CONTROLPOLICY_H_
 #define _OPENCOG_CONTROLPOLICY_H_
 
+#include <shared_mutex>
+
 #include <opencog/atomspace/AtomSpace.h>
 
 #include "BIT.h"
 #include "../UREConfig.h"
 #include "../Rule.h"
+#include "../AtomSpacePool.h"
 
 class ControlPolicyUTest;
 
@@ -57,6 +60,11 @@ public:
 	// Inference rule set for expanding and-BITs.
 	RuleSet rules;
 
+	// Protect rules, as well as the exhausted flags of the BIT-nodes,
+	// which depend on it. Held shared while selecting rules, and
+	// exclusively while expanding meta rules.
+	mutable std::shared_timed_mutex rules_mutex;
+
 	/**
 	 * Select a valid inference rule given a target. The selected is a
 	 * new object because a new rule is created, its variables are
@@ -81,6 +89,12 @@ public:
 	 */
 	static HandleSet rule_aliases(const RuleTypedSubstitutionMap& rules);
 
+	/**
+	 * Number of scratch atomspaces allocated so far to match control
+	 * rules.
+	 */
+	size_t scratch_atomspaces_allocated() const;
+
 private:
 	// Reference to URE configuration
 	const UREConfig& _ure_config;
@@ -110,6 +124,9 @@ private:
 	// various control rule
 	AtomSpace* _query_as;
 
+	// Scratch atomspaces, without parent, used by match
+	mutable AtomSpacePool _scratch_as_pool;
+
 	// Map each action (inference rule expansion) to the set of
 	// control rules involving it.
 	std::map<Handle, HandleSet> _expansion_control_rules;
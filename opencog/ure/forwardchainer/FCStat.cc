@@ -21,36 +21,167 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
+
+#include <opencog/util/oc_assert.h>
+
 #include "FCStat.h"
 #include <opencog/atoms/core/NumberNode.h>
 
 using namespace opencog;
 
-void FCStat::add_inference_record(unsigned iteration, Handle source,
-                                  const Rule& rule,
-                                  const HandleSet& product)
+FCStat::FCStat(AtomSpace* trace_as, const RuleTable& rule_table)
+	: _reserved(0), _size(0), _trace_as(trace_as),
+	  _rule_table(rule_table), _merged(0), _traced(0)
 {
-	{
-		std::lock_guard<std::mutex> lock(_whole_mutex);
-		_inf_rec.emplace_back(source, rule, product);
+	for (auto& segment : _segments)
+		segment.store(nullptr);
+}
+
+FCStat::~FCStat()
+{
+	for (auto& segment : _segments)
+		delete[] segment.load();
+}
+
+void FCStat::locate(size_t i, size_t& segment, size_t& offset)
+{
+	// Segment k starts at index first_segment_size * (2^k - 1)
+	size_t j = i / first_segment_size + 1;
+	segment = 0;
+	while (j >>= 1)
+		segment++;
+	offset = i - first_segment_size * ((size_t(1) << segment) - 1);
+}
+
+FCStat::Slot& FCStat::slot(size_t i)
+{
+	size_t k, offset;
+	locate(i, k, offset);
+	OC_ASSERT(k < max_segments);
+	Slot* segment = _segments[k].load(std::memory_order_acquire);
+	if (not segment) {
+		// Allocate the segment, unless another appender has done it
+		// meanwhile
+		Slot* new_segment = new Slot[first_segment_size << k];
+		if (_segments[k].compare_exchange_strong(segment, new_segment,
+		                                         std::memory_order_acq_rel))
+			segment = new_segment;
+		else
+			delete[] new_segment;
 	}
+	return segment[offset];
+}
+
+const FCStat::Slot* FCStat::find_slot(size_t i) const
+{
+	size_t k, offset;
+	locate(i, k, offset);
+	const Slot* segment = _segments[k].load(std::memory_order_acquire);
+	return segment ? segment + offset : nullptr;
+}
 
-	if (_trace_as and not product.empty()) {
-		Handle schema = rule.get_alias();
-		Handle i = _trace_as->add_node(NUMBER_NODE, std::to_string(iteration + 1));
-		Handle inputs = _trace_as->add_link(LIST_LINK, source, i);
-		for (const Handle& output : product) {
+void FCStat::add_inference_record(unsigned iteration, const Handle& source,
+                                  RuleTable::RuleId rule, HandleSet product)
+{
+	Slot& s = slot(_reserved.fetch_add(1));
+	s.record.iteration = iteration;
+	s.record.hsource = source;
+	s.record.rule = rule;
+	s.record.product = std::move(product);
+	s.ready.store(true, std::memory_order_release);
+}
+
+void FCStat::flush_trace()
+{
+	if (not _trace_as)
+		return;
+
+	std::lock_guard<std::mutex> lock(_trace_mutex);
+	size_t end = size();
+	for (; _traced < end; _traced++) {
+		const InferenceRecord& ir = find_slot(_traced)->record;
+		if (ir.product.empty())
+			continue;
+		Handle schema = _rule_table[ir.rule].get_alias();
+		Handle i = _trace_as->add_node(NUMBER_NODE,
+		                               std::to_string(ir.iteration + 1));
+		Handle inputs = _trace_as->add_link(LIST_LINK, ir.hsource, i);
+		for (const Handle& output : ir.product)
 			_trace_as->add_link(EXECUTION_LINK, schema, inputs, output);
-		}
 	}
 }
 
+void FCStat::merge_products() const
+{
+	size_t end = size();
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(_products_mutex);
+		if (end <= _merged)
+			return;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(_products_mutex);
+	for (; _merged < end; _merged++)
+		for (const Handle& product : find_slot(_merged)->record.product)
+			if (_products.insert(product).second)
+				_products_seq.push_back(product);
+}
+
 HandleSet FCStat::get_all_products() const
 {
-	std::lock_guard<std::mutex> lock(_whole_mutex);
-	HandleSet all;
-	for(const auto& ir : _inf_rec)
-		all.insert(ir.product.begin(),ir.product.end());
+	merge_products();
+	std::shared_lock<std::shared_timed_mutex> lock(_products_mutex);
+	return _products;
+}
 
-	return all;
+size_t FCStat::num_products() const
+{
+	merge_products();
+	std::shared_lock<std::shared_timed_mutex> lock(_products_mutex);
+	return _products.size();
+}
+
+HandleSeq FCStat::get_products_seq(size_t from) const
+{
+	merge_products();
+	std::shared_lock<std::shared_timed_mutex> lock(_products_mutex);
+	if (_products_seq.size() <= from)
+		return HandleSeq();
+	return HandleSeq(_products_seq.begin() + from, _products_seq.end());
+}
+
+size_t FCStat::size() const
+{
+	// Advance over the slots that have become ready since last time
+	size_t n = _size.load(std::memory_order_acquire);
+	size_t reserved = _reserved.load(std::memory_order_acquire);
+	size_t m = n;
+	for (; m < reserved; m++) {
+		const Slot* s = find_slot(m);
+		if (not s or not s->ready.load(std::memory_order_acquire))
+			break;
+	}
+	while (n < m and not _size.compare_exchange_weak(n, m));
+	return std::max(n, m);
+}
+
+HandleSet FCStat::get_products(size_t from, size_t to) const
+{
+	HandleSet products;
+	to = std::min(to, size());
+	for (size_t i = from; i < to; i++) {
+		const HandleSet& product = find_slot(i)->record.product;
+		products.insert(product.begin(), product.end());
+	}
+	return products;
+}
+
+std::vector<InferenceRecord> FCStat::get_records(size_t from, size_t to) const
+{
+	std::vector<InferenceRecord> records;
+	to = std::min(to, size());
+	for (size_t i = from; i < to; i++)
+		records.push_back(find_slot(i)->record);
+	return records;
 }
@@ -24,37 +24,67 @@
 #ifndef _OPENCOG_FCSTAT_H_
 #define _OPENCOG_FCSTAT_H_
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 #include <opencog/atoms/base/Handle.h>
 #include <opencog/ure/Rule.h>
 
+#include "RuleTable.h"
+
 namespace opencog {
 
+/**
+ * Record of an inference step. The rule is referred to by its id in
+ * the rule table of the chainer, so that records do not hold
+ * references to rules, which may be invalidated as meta rules get
+ * expanded.
+ */
 struct InferenceRecord
 {
-	const Handle hsource;
-	const Rule& rule;
+	unsigned iteration;
+	Handle hsource;
+	RuleTable::RuleId rule;
 	HandleSet product;
-
-	InferenceRecord(Handle h, const Rule& r, const HandleSet& p)
-		: hsource(h), rule(r), product(p) {}
 };
 
+/**
+ * Append-only log of the inference steps of a forward chainer.
+ *
+ * Records are appended without locks into segments of geometrically
+ * growing sizes, so that records never move and can be read while
+ * others are being appended. The trace atomspace, if any, is only
+ * filled by flush_trace, rather than on each step.
+ *
+ * The set of all products is maintained incrementally, by merging
+ * the products of the records appended since the last query.
+ */
 class FCStat
 {
 public:
-	FCStat(AtomSpace* trace_as) : _trace_as(trace_as) {}
+	FCStat(AtomSpace* trace_as, const RuleTable& rule_table);
+	~FCStat();
 
 	/**
-	 * Record the inference step into memory, as well as in the
-	 * atomspace according to the following format:
+	 * Record the inference step into memory. Can be called
+	 * concurrently.
+	 */
+	void add_inference_record(unsigned iteration, const Handle& source,
+	                          RuleTable::RuleId rule, HandleSet product);
+
+	/**
+	 * Write the inference steps recorded since the last flush into
+	 * the trace atomspace, if any, according to the following format:
 	 *
 	 * ExecutionLink
 	 *    <rule>
 	 *    List
-	 *      <step>
 	 *      <source>
+	 *      <step>
 	 *    <product>
 	 *
 	 * where
@@ -62,19 +92,94 @@ public:
 	 * 1. <rule> is DefinedSchemaNode <rule-name>
 	 * 2. <step> is NumberNode <#iteration>
 	 * 3. <source> is the source
-	 * 4. <product> is a SetLink <p1> ... <pn> where pi are the products
+	 * 4. <product> is a product
+	 */
+	void flush_trace();
+
+	/**
+	 * Return all distinct products so far.
 	 */
-	void add_inference_record(unsigned iteration, Handle source,
-	                          const Rule& rule, const HandleSet& product);
 	HandleSet get_all_products() const;
-	HandleSet get_all_products();
+
+	/**
+	 * Return the number of distinct products so far.
+	 */
+	size_t num_products() const;
+
+	/**
+	 * Return the distinct products from the from-th one, in order of
+	 * first inference. Useful to poll the products while chaining,
+	 * passing the number of products obtained so far.
+	 */
+	HandleSeq get_products_seq(size_t from=0) const;
+
+	/**
+	 * Return the number of inference records so far, which can be
+	 * used as a cursor for get_products. Records being appended
+	 * concurrently are only counted once all records before them have
+	 * been appended.
+	 */
+	size_t size() const;
+
+	/**
+	 * Return the products of the inference records in [from, to).
+	 */
+	HandleSet get_products(size_t from, size_t to) const;
+
+	/**
+	 * Return the inference records in [from, to), in order of
+	 * appending.
+	 */
+	std::vector<InferenceRecord> get_records(size_t from, size_t to) const;
 
 private:
-	std::vector<InferenceRecord> _inf_rec;
+	struct Slot
+	{
+		InferenceRecord record;
+		std::atomic<bool> ready{false};
+	};
+
+	// Segment k holds first_segment_size * 2^k slots
+	static const size_t first_segment_size = 64;
+	static const size_t max_segments = 48;
+
+	// Return the slot at index i, allocating its segment if needed
+	Slot& slot(size_t i);
+
+	// Return the slot at index i, or nullptr if its segment has not
+	// been allocated yet
+	const Slot* find_slot(size_t i) const;
+
+	// Map index i to its segment and offset within it
+	static void locate(size_t i, size_t& segment, size_t& offset);
+
+	std::array<std::atomic<Slot*>, max_segments> _segments;
+
+	// Number of slots reserved by appenders
+	std::atomic<size_t> _reserved;
+
+	// Lower bound of the number of ready slots, so that size() does
+	// not scan the whole log each time
+	mutable std::atomic<size_t> _size;
+
 	AtomSpace* _trace_as;
+	const RuleTable& _rule_table;
+
+	// Merge the products of the records appended since the last
+	// merge into _products and _products_seq.
+	void merge_products() const;
+
+	// Distinct products of the first _merged records, as a set and in
+	// order of first inference, guarded by _products_mutex
+	mutable HandleSet _products;
+	mutable HandleSeq _products_seq;
+	mutable size_t _merged;
+	mutable std::shared_timed_mutex _products_mutex;
 
-	// NEXT TODO: subdivide in smaller and shared mutexes
-	mutable std::mutex _whole_mutex;
+	// Number of records written in the trace atomspace, guarded by
+	// _trace_mutex
+	size_t _traced;
+	std::mutex _trace_mutex;
 };
 
 }
@@ -21,27 +21,32 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include <future>
-#include <thread>
-#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <map>
 
 #include <boost/range/adaptor/reversed.hpp>
 
 #include <opencog/util/random.h>
-#include <opencog/util/pool.h>
 #include <opencog/atoms/core/VariableList.h>
 #include <opencog/atoms/core/FindUtils.h>
 #include <opencog/atoms/pattern/BindLink.h>
+#include <opencog/atoms/execution/EvaluationLink.h>
 #include <opencog/atoms/pattern/PatternUtils.h>
 #include <opencog/ure/Rule.h>
+#include <opencog/ure/RuleImplicator.h>
 
 #include "ForwardChainer.h"
 #include "../URELogger.h"
+#include "../URERandGen.h"
 #include "../backwardchainer/ControlPolicy.h"
 #include "../ThompsonSampling.h"
 
 using namespace opencog;
 
+const size_t ForwardChainer::max_work_queue_size = 64;
+const int ForwardChainer::trace_flush_period = 16;
+
 ForwardChainer::ForwardChainer(AtomSpace& kb_as,
                                AtomSpace& rb_as,
                                const Handle& rbs,
@@ -51,10 +56,10 @@ ForwardChainer::ForwardChainer(AtomSpace& kb_as,
                                const HandleSeq& focus_set)
 	: _kb_as(kb_as),
 	  _rb_as(rb_as),
+	  _scratch_as_pool(&kb_as),
 	  _config(rb_as, rbs),
-	  _thread_count(0),
 	  _sources(_config, source, vardecl),
-	  _fcstat(trace_as)
+	  _fcstat(trace_as, _rule_table)
 {
 	init(source, vardecl, focus_set);
 }
@@ -83,12 +88,12 @@ void ForwardChainer::init(const Handle& source,
 
 	_search_focus_set = not focus_set.empty();
 
-	// Add focus set atoms and sources to focus_set atomspace
+	// Add focus set atoms and sources to the focus set filter
 	if (_search_focus_set) {
 		for (const Handle& h : focus_set)
-			_focus_set_as.add_atom(h);
+			insert_focus_set(h);
 		for (const Source& src : _sources.sources)
-			_focus_set_as.add_atom(src.body);
+			insert_focus_set(src.body);
 	}
 
 	// Set rules.
@@ -97,9 +102,23 @@ void ForwardChainer::init(const Handle& source,
 	// the new standard when all rules have been ported to the new one.
 	for (const Rule& rule : _rules)
 		rule.premises_as_clauses = true; // can be modify as mutable
+	_premise_index.insert(_rules);
 
-	// Reset the iteration count
+	// Reset the iteration and query counts
 	_iteration = 0;
+	_queries_count = 0;
+
+	// Meta rules have not been expanded yet
+	_meta_expanded = false;
+	_meta_cursor = 0;
+
+	// Own cancellation token, replaced by the one passed to do_chain,
+	// if any, during that chaining
+	std::atomic_store(&_token, std::make_shared<CancellationToken>());
+
+	// Start of the chaining, reset by do_chain
+	_start_time = std::chrono::steady_clock::now();
+	_start_kb_size = _kb_as.get_size();
 }
 
 UREConfig& ForwardChainer::get_config()
@@ -112,16 +131,35 @@ const UREConfig& ForwardChainer::get_config() const
 	return _config;
 }
 
-void ForwardChainer::do_chain()
+size_t ForwardChainer::scratch_atomspaces_allocated() const
+{
+	return _scratch_as_pool.allocated();
+}
+
+void ForwardChainer::do_chain(const CancellationTokenPtr& token)
 {
+	// Use the given token, if any, for that chaining only
+	ScopedCancellationToken scoped_token(_token, token);
+
 	ure_logger().debug("Start forward chaining");
 	LAZY_URE_LOG_DEBUG << "With rule set:" << std::endl << oc_to_string(_rules);
 
+	// Record the start of the chaining to check the budgets
+	_start_time = std::chrono::steady_clock::now();
+	_start_kb_size = _kb_as.get_size();
+
+	// Seed the random generator of the calling thread. Workers of
+	// the multi-threaded chainer seed their own.
+	std::unique_ptr<ScopedRandGen> randgen;
+	if (0 <= _config.get_random_seed())
+		randgen.reset(new ScopedRandGen(_config.get_random_seed()));
+
 	// Relex2Logic uses this. TODO make a separate class to handle
 	// this robustly.
 	if(_sources.empty())
 	{
 		apply_all_rules();
+		flush_trace();
 		return;
 	}
 
@@ -142,6 +180,9 @@ void ForwardChainer::do_chain()
 		ure_logger().set_thread_id_flag(prev_thread_id);
 	}
 
+	// Write the rest of the inference trace
+	flush_trace();
+
 	// Log termination messages
 	termination_log();
 	LAZY_URE_LOG_DEBUG << "Finished forward chaining with results:"
@@ -150,101 +191,395 @@ void ForwardChainer::do_chain()
 
 void ForwardChainer::do_steps_singlethread()
 {
-	while (not termination()) do_step(_iteration++);
+	while (not termination()) {
+		int iteration = _iteration++;
+		do_step(iteration);
+		flush_trace(iteration);
+	}
 }
 
-// TODO: if creating/destroying threads is too expensive, use a thread
-// pool (see boost::asio::thread_pool).
 void ForwardChainer::do_steps_multithread()
 {
-	// Create a pool of iterations
-	opencog::pool<int> itrpool;
+	if (_config.get_deterministic()) {
+		do_steps_deterministic();
+		return;
+	}
 
-	// Run steps in parallel
-	while (not termination())
-	{
-		if (_thread_count < _config.get_jobs())
-			itrpool.give_back(_iteration++);
+	unsigned jobs = _config.get_jobs();
+	_pool.reserve(jobs);
+
+	// Create one work queue per worker
+	for (unsigned i = 0; i < jobs; i++)
+		_work_queues.emplace_back(new WorkQueue());
+
+	// Each worker keeps claiming and running iterations till
+	// termination, drawing from its own random stream if seeded
+	int seed = _config.get_random_seed();
+	for (unsigned i = 0; i < jobs; i++)
+		_pool.push([this, i, seed]() {
+				std::unique_ptr<ScopedRandGen> randgen;
+				if (0 <= seed)
+					randgen.reset(new ScopedRandGen(derive_seed(seed, i)));
+				int iteration;
+				while (claim_iteration(iteration)) {
+					do_step(iteration, i);
+					flush_trace(iteration);
+				}
+			});
+
+	// Wait for all workers to be done, then drain the work queues,
+	// releasing the sources they still hold so that they can be
+	// evicted by later runs.
+	_pool.wait();
+	for (const auto& queue : _work_queues)
+		for (Source* src : queue->sources)
+			_sources.release(*src);
+	_work_queues.clear();
+}
 
-		int local_iteration = itrpool.borrow();
-		if (local_iteration < 0)
-			// A negative iteration resource is freed to unstuck the main
-			// thread and indicates that the process has terminated.
-			break;
+void ForwardChainer::do_steps_deterministic()
+{
+	if (1 < _config.get_batch_size())
+		ure_logger().warn() << "Batch size " << _config.get_batch_size()
+		                    << " is ignored in deterministic mode, "
+		                    << "each iteration selects a single source";
+
+	unsigned jobs = _config.get_jobs();
+	_pool.reserve(jobs);
+
+	bool claimed = true;
+	std::vector<std::unique_ptr<Step>> round;
+	while (claimed) {
+		// Select the sources and rules of the round, in iteration
+		// order, by the calling thread
+		round.clear();
+		int iteration;
+		while (round.size() < jobs and (claimed = claim_iteration(iteration))) {
+			std::unique_ptr<Step> step(new Step(iteration));
+			ure_logger().debug() << step->msgprfx << "Start iteration ("
+			                     << iteration + 1 << "/"
+			                     << _config.get_maximum_iterations_str() << ")";
+			expand_meta_rules(step->msgprfx);
+			if (select_step(*step, -1)) {
+				step->lease.reset(new AtomSpacePool::Lease(_scratch_as_pool.borrow()));
+				round.push_back(std::move(step));
+			}
+		}
 
-		_thread_count++;
-		auto do_step_manage = [=,&itrpool]() {
-			do_step(local_iteration);
-			itrpool.give_back(termination() ? -1 : _iteration++);
-			_thread_count--; };
-		auto thrd = std::thread(do_step_manage);
-		thrd.detach();
-	}
+		// Apply their rules in parallel, each in its own scratch
+		// atomspace, so that they do not see each other's products
+		for (const auto& step : round) {
+			Step* stp = step.get();
+			_pool.push([this, stp]() { apply_step(*stp, stp->lease->get()); });
+		}
+		_pool.wait();
 
-	// Wait for the remaining threads to terminate
-	using namespace std::chrono_literals;
-	while (0 < _thread_count) std::this_thread::sleep_for(1ms);
+		// Commit their results in iteration order
+		for (const auto& step : round) {
+			commit_step(*step, -1);
+			flush_trace(step->iteration);
+		}
+	}
 }
 
-void ForwardChainer::do_step(int iteration)
+ForwardChainer::Step::Step(int it)
+	: iteration(it),
+	  msgprfx(std::string("[I-") + std::to_string(it + 1) + "] "),
+	  source(nullptr),
+	  prob(0.0),
+	  rule_id(RuleTable::npos) {}
+
+void ForwardChainer::do_step(int iteration, int worker)
 {
-	int lipo = iteration + 1;
-	std::string msgprfx = std::string("[I-") + std::to_string(lipo) + "] ";
-	ure_logger().debug() << msgprfx << "Start iteration (" << lipo
+	Step step(iteration);
+	const std::string& msgprfx = step.msgprfx;
+	ure_logger().debug() << msgprfx << "Start iteration (" << iteration + 1
 	                     << "/" << _config.get_maximum_iterations_str() << ")";
 
 	// Expand meta rules. This should probably be done on-the-fly in
 	// the select_rule method, but for now it's here
 	expand_meta_rules(msgprfx);
 
-	// Select source
-	Source* source = select_source(msgprfx);
+	if (1 < _config.get_batch_size()) {
+		do_batch_step(iteration, worker, msgprfx);
+		return;
+	}
+
+	if (not select_step(step, worker))
+		return;
+	apply_step(step);
+	commit_step(step, worker);
+}
+
+bool ForwardChainer::select_step(Step& step, int worker)
+{
+	const std::string& msgprfx = step.msgprfx;
+
+	// Select source, preferably from the work queues if multi-threaded
+	Source* source = select_any_source(worker, msgprfx);
 	if (source) {
 		LAZY_URE_LOG_DEBUG << msgprfx << "Selected source:" << std::endl
 		                   << source->to_string();
 	} else {
 		LAZY_URE_LOG_DEBUG << msgprfx << "No source selected, abort iteration";
-		return;
+		return false;
 	}
 
+	// The source is held by the step so that it is not evicted from
+	// the population meanwhile
+	step.source = source;
+	step.guard.reset(new SourceSet::ReleaseGuard(_sources, *source));
+
 	// Select rule
 	RuleProbabilityPair rule_prob = select_rule(*source, msgprfx);
 	const Rule& rule = rule_prob.first;
 	double prob(rule_prob.second);
 	if (not rule.is_valid()) {
+		// No valid rule left for that source, it is exhausted
+		_sources.set_exhausted(*source);
 		ure_logger().debug() << msgprfx << "No selected rule, abort iteration";
-		return;
+		return false;
 	} else {
 		LAZY_URE_LOG_DEBUG << msgprfx << "Selected rule, with probability " << prob
 		                   << " of success:" << std::endl << rule.to_string();
 	}
 
-	if (source->insert_rule(rule)) {
-		// Apply rule on source
-		HandleSet products = apply_rule(rule);
-
-		// Insert the produced sources in the population of sources
-		_sources.insert(products, *source, prob, msgprfx);
-
-		// The rule has been applied, we can set the exhausted flag
-		source->set_rule_exhausted(rule);
+	// Do not start a new rule application if the chaining has been
+	// cancelled meanwhile
+	if (is_cancelled()) {
+		ure_logger().debug() << msgprfx << "Chaining cancelled, abort iteration";
+		return false;
+	}
 
-		// Save trace and results
-		_fcstat.add_inference_record(iteration, source->body, rule, products);
-	} else {
+	Source::RuleId rule_id = _rule_table.intern(rule);
+	if (not source->insert_rule(rule_id)) {
 		LAZY_URE_LOG_DEBUG << msgprfx << "Rule " << rule.to_short_string()
 		                   << " is probably being applied on source "
 		                   << source->body->id_to_string()
 		                   << " in another thread. Abort iteration.";
+		return false;
+	}
+	step.rule = rule;
+	step.prob = prob;
+	step.rule_id = rule_id;
+
+	// Claim the atoms to apply the rule over in semi-naive mode
+	if (_config.get_full_rule_application()
+	    and _config.get_semi_naive_rule_application())
+		step.delta = claim_semi_naive_delta(rule);
+
+	return true;
+}
+
+void ForwardChainer::apply_step(Step& step, AtomSpace* as)
+{
+	step.products =
+		_config.get_full_rule_application()
+		and _config.get_semi_naive_rule_application() ?
+		apply_rule_semi_naive(step.rule, step.delta, as) :
+		apply_rule(step.rule, as);
+}
+
+void ForwardChainer::commit_step(Step& step, int worker)
+{
+	// Move the products to the knowledge base if they have been
+	// produced in a scratch atomspace
+	if (step.lease) {
+		HandleSet products;
+		for (const Handle& h : step.products)
+			products.insert(_kb_as.add_atom(h));
+		step.products.swap(products);
+		step.lease.reset();
+	}
+
+	// Insert the produced sources in the population of sources,
+	// holding them if they are to be queued
+	std::vector<Source*> new_srcs =
+		_sources.insert(step.products, *step.source, step.prob,
+		                step.msgprfx, 0 <= worker);
+
+	// Queue them to be expanded next by that worker
+	if (0 <= worker)
+		push_queued_sources(worker, new_srcs);
+
+	// The rule has been applied, we can set the exhausted flag
+	step.source->set_rule_exhausted(step.rule_id);
+
+	// Let the products be used as premises within the focus set
+	insert_focus_set(step.products);
+
+	// Stream the results to the subscribers
+	notify(step.products);
+
+	// Save trace and results
+	_fcstat.add_inference_record(step.iteration, step.source->body,
+	                             step.rule_id, std::move(step.products));
+}
+
+void ForwardChainer::do_batch_step(int iteration, int worker,
+                                   const std::string& msgprfx)
+{
+	// Select up to batch size distinct sources, held till the end of
+	// the step
+	std::vector<Source*> sources;
+	std::vector<std::unique_ptr<SourceSet::ReleaseGuard>> guards;
+	for (int i = 0; i < _config.get_batch_size(); i++) {
+		Source* source = select_any_source(worker, msgprfx);
+		if (not source)
+			break;
+		guards.emplace_back(new SourceSet::ReleaseGuard(_sources, *source));
+		if (std::find(sources.begin(), sources.end(), source) == sources.end())
+			sources.push_back(source);
+	}
+	if (sources.empty()) {
+		LAZY_URE_LOG_DEBUG << msgprfx << "No source selected, abort iteration";
+		return;
+	}
+	LAZY_URE_LOG_DEBUG << msgprfx << "Selected " << sources.size()
+	                   << " sources";
+
+	// Select a rule for each source
+	std::vector<std::pair<Source*, RuleProbabilityPair>> selections;
+	for (Source* source : sources) {
+		RuleProbabilityPair rule_prob = select_rule(*source, msgprfx);
+		if (rule_prob.first.is_valid())
+			selections.emplace_back(source, rule_prob);
+		else
+			// No valid rule left for that source, it is exhausted
+			_sources.set_exhausted(*source);
+	}
+
+	// Do not start new rule applications if the chaining has been
+	// cancelled meanwhile
+	if (is_cancelled()) {
+		ure_logger().debug() << msgprfx << "Chaining cancelled, abort iteration";
+		return;
+	}
+
+	// Group the sources by selected rule. In full rule application
+	// mode it is the unaltered rule. Otherwise specializations of the
+	// same premise of the same rule over constant sources are grouped
+	// together, so that the rule is applied once over all of them, by
+	// binding that premise to the members of the group.
+	struct RuleGroup
+	{
+		Rule rule;
+		size_t premise;
+		double prob;
+		std::vector<Source*> sources;
+		std::vector<Source::RuleId> rule_ids;
+	};
+	static const size_t npos = std::numeric_limits<size_t>::max();
+	std::map<std::pair<size_t, size_t>, RuleGroup> groups;
+	for (auto& selection : selections) {
+		Source* source = selection.first;
+		const Rule& rule = selection.second.first;
+		Source::RuleId rule_id = _rule_table.intern(rule);
+		if (not source->insert_rule(rule_id)) {
+			LAZY_URE_LOG_DEBUG << msgprfx << "Rule " << rule.to_short_string()
+			                   << " is probably being applied on source "
+			                   << source->body->id_to_string()
+			                   << " in another thread. Skip it.";
+			continue;
+		}
+		RuleTable::Origin origin = _rule_table.origin(rule_id);
+		bool batchable = not _config.get_full_rule_application()
+			and origin.is_known() and not source->vardecl;
+		std::pair<size_t, size_t> key = batchable ?
+			std::make_pair(origin.rule, origin.premise) :
+			std::make_pair(npos, (size_t)rule_id);
+		auto it = groups.find(key);
+		if (it == groups.end())
+			it = groups.emplace(key, RuleGroup{rule, batchable ?
+			                                   origin.premise : npos,
+			                                   selection.second.second,
+			                                   {}, {}}).first;
+		it->second.sources.push_back(source);
+		it->second.rule_ids.push_back(rule_id);
+	}
+
+	// Apply each rule once. The products of a group are inserted as
+	// expanded from its least complex source.
+	std::vector<SourceSet::Production> productions;
+	for (const auto& key_group : groups) {
+		const RuleGroup& group = key_group.second;
+		HandleSet products;
+		if (group.premise != npos and 1 < group.sources.size()) {
+			Rule rule;
+			{
+				std::shared_lock<std::shared_timed_mutex> lock(_rules_mutex);
+				rule = _rules[key_group.first.first];
+			}
+			LAZY_URE_LOG_DEBUG << msgprfx << "Apply rule "
+			                   << rule.to_short_string() << " over "
+			                   << group.sources.size() << " sources";
+			products = apply_rule(rule, group.sources, group.premise);
+		} else {
+			LAZY_URE_LOG_DEBUG << msgprfx << "Apply rule "
+			                   << group.rule.to_short_string() << " over "
+			                   << group.sources.size() << " sources";
+			products =
+				_config.get_full_rule_application()
+				and _config.get_semi_naive_rule_application() ?
+				apply_rule_semi_naive(group.rule) : apply_rule(group.rule);
+		}
+		const Source* src = *std::min_element(
+			group.sources.begin(), group.sources.end(),
+			[](const Source* l, const Source* r) {
+				return l->complexity < r->complexity; });
+		productions.push_back({std::move(products), src, group.prob});
 	}
+
+	// Insert all products in the population at once, holding them if
+	// they are to be queued
+	std::vector<Source*> new_srcs =
+		_sources.insert(productions, msgprfx, 0 <= worker);
+	if (0 <= worker)
+		push_queued_sources(worker, new_srcs);
+
+	// Set the rules exhausted, save traces and results, and stream
+	// them to the subscribers
+	size_t i = 0;
+	for (const auto& key_group : groups) {
+		const RuleGroup& group = key_group.second;
+		const HandleSet& products = productions[i++].products;
+		insert_focus_set(products);
+		for (size_t j = 0; j < group.sources.size(); j++) {
+			group.sources[j]->set_rule_exhausted(group.rule_ids[j]);
+			_fcstat.add_inference_record(iteration, group.sources[j]->body,
+			                             group.rule_ids[j], products);
+		}
+		notify(products);
+	}
+}
+
+bool ForwardChainer::claim_iteration(int& iteration)
+{
+	if (termination())
+		return false;
+
+	// Atomically increment the iteration counter, making sure it does
+	// not go beyond the maximum number of iterations if another
+	// worker has claimed it in the meantime.
+	int max_iter = _config.get_maximum_iterations();
+	iteration = _iteration;
+	do {
+		if (0 <= max_iter and max_iter <= iteration)
+			return false;
+	} while (not _iteration.compare_exchange_weak(iteration, iteration + 1));
+	return true;
 }
 
 bool ForwardChainer::termination()
 {
 	bool terminate = false;
 
+	// Terminate if the chaining has been cancelled
+	if (is_cancelled()) {
+		terminate = true;
+	}
 	// Terminate if all sources have been tried
-	if (_sources.is_exhausted()) {
+	else if (_sources.is_exhausted()) {
 		terminate = true;
 	}
 	// Terminate if max iterations has been reached
@@ -252,6 +587,10 @@ bool ForwardChainer::termination()
 	         _config.get_maximum_iterations() <= _iteration) {
 		terminate = true;
 	}
+	// Terminate if some budget has been exceeded
+	else if (not exceeded_budget().empty()) {
+		terminate = true;
+	}
 
 	return terminate;
 }
@@ -260,8 +599,12 @@ void ForwardChainer::termination_log()
 {
 	std::string msg;
 
+	// Terminate if the chaining has been cancelled
+	if (is_cancelled()) {
+		msg = "the chaining has been cancelled";
+	}
 	// Terminate if all sources have been tried
-	if (_sources.is_exhausted()) {
+	else if (_sources.is_exhausted()) {
 		msg = "all sources have been exhausted";
 	}
 	// Terminate if max iterations has been reached
@@ -269,6 +612,10 @@ void ForwardChainer::termination_log()
 	         _config.get_maximum_iterations() <= _iteration) {
 		msg = "reach maximum number of iterations";
 	}
+	// Terminate if some budget has been exceeded
+	else {
+		msg = exceeded_budget();
+	}
 
 	ure_logger().debug() << "Terminate: " << msg;
 }
@@ -281,11 +628,17 @@ void ForwardChainer::apply_all_rules()
 	for (const Rule& rule : _rules) {
 		ure_logger().debug("Apply rule %s", rule.get_name().c_str());
 		HandleSet uhs = apply_rule(rule);
+		insert_focus_set(uhs);
+
+		// Stream the results to the subscribers
+		notify(uhs);
 
 		// Update
 		_fcstat.add_inference_record(_iteration,
 		                             _kb_as.add_node(CONCEPT_NODE, "dummy-source"),
-		                             rule, uhs);
+		                             _rule_table.intern(rule), std::move(uhs));
+		if (is_cancelled())
+			break;
 	}
 }
 
@@ -301,41 +654,122 @@ HandleSet ForwardChainer::get_results_set() const
 	return _fcstat.get_all_products();
 }
 
+size_t ForwardChainer::get_results_size() const
+{
+	return _fcstat.num_products();
+}
+
+void ForwardChainer::flush_trace()
+{
+	_fcstat.flush_trace();
+}
+
+void ForwardChainer::flush_trace(int iteration)
+{
+	if ((iteration + 1) % trace_flush_period == 0)
+		_fcstat.flush_trace();
+}
+
+HandleSeq ForwardChainer::get_results_seq(size_t from) const
+{
+	return _fcstat.get_products_seq(from);
+}
+
+std::string ForwardChainer::exceeded_budget() const
+{
+	double max_time = _config.get_maximum_time();
+	if (0 <= max_time) {
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - _start_time;
+		if (max_time <= elapsed.count())
+			return "reach maximum time";
+	}
+
+	int max_kba = _config.get_maximum_kb_additions();
+	if (0 <= max_kba and _start_kb_size + max_kba <= _kb_as.get_size())
+		return "reach maximum number of atoms added to the knowledge base";
+
+	int max_ps = _config.get_maximum_population_size();
+	if (0 <= max_ps and (size_t)max_ps <= _sources.size())
+		return "reach maximum number of sources";
+
+	return "";
+}
+
+void ForwardChainer::subscribe(const ResultCallback& callback)
+{
+	std::lock_guard<std::mutex> lock(_subscribers_mutex);
+	_subscribers.push_back(callback);
+}
+
+void ForwardChainer::subscribe(const Handle& predicate)
+{
+	AtomSpace& as = _kb_as;
+	subscribe([&as, predicate](const Handle& product) {
+			Handle args = createLink(LIST_LINK, product),
+				eval = createLink(EVALUATION_LINK, predicate, args);
+			TruthValuePtr tv = EvaluationLink::do_evaluate(&as, eval);
+			return 0.5 <= tv->get_mean();
+		});
+}
+
+void ForwardChainer::cancel()
+{
+	std::atomic_load(&_token)->cancel();
+}
+
+bool ForwardChainer::is_cancelled() const
+{
+	return std::atomic_load(&_token)->is_cancelled();
+}
+
+void ForwardChainer::notify(const HandleSet& products)
+{
+	std::lock_guard<std::mutex> lock(_subscribers_mutex);
+	for (const Handle& product : products) {
+		for (const ResultCallback& callback : _subscribers) {
+			if (not callback(product)) {
+				ure_logger().debug() << "Chaining cancelled by subscriber on "
+				                     << product->id_to_string();
+				cancel();
+				return;
+			}
+		}
+	}
+}
+
+Source* ForwardChainer::select_any_source(int worker,
+                                          const std::string& msgprfx)
+{
+	Source* source = nullptr;
+	if (0 <= worker)
+		source = select_queued_source(worker, msgprfx);
+	if (not source)
+		source = select_source(msgprfx);
+	return source;
+}
+
 Source* ForwardChainer::select_source(const std::string& msgprfx)
 {
 	// TODO: refine mutex
 	std::unique_lock<std::mutex> lock(_part_mutex);
 
-	std::vector<double> weights = _sources.get_weights();
-
-	// Debug log
+	// Debug log. Only the weights are read, as they are copied under
+	// the lock of the source set, while sources may be concurrently
+	// evicted.
 	if (ure_logger().is_debug_enabled()) {
-		OC_ASSERT(weights.size() == _sources.size());
-		size_t wi = 0;
-		// Sort sources according to their weights
-		std::multimap<double, Handle> weighted_sources;
-		for (size_t i = 0; i < weights.size(); i++) {
-			if (0 < weights[i]) {
-				wi++;
-				if (ure_logger().is_fine_enabled()) {
-					weighted_sources.insert({weights[i], _sources.sources[i].body});
-				}
-			}
-		}
+		std::vector<double> weights = _sources.get_weights();
+		size_t wi = std::count_if(weights.begin(), weights.end(),
+		                          [](double w) { return 0 < w; });
 		LAZY_URE_LOG_DEBUG << msgprfx << "Positively weighted sources ("
 		                   << wi << "/" << weights.size() << ")";
-		if (ure_logger().is_fine_enabled()) {
-			std::stringstream ws_ss;
-			for (const auto& wsp : boost::adaptors::reverse(weighted_sources))
-				ws_ss << std::endl << wsp.first << " " << wsp.second->id_to_string();
-			LAZY_URE_LOG_FINE << msgprfx << ws_ss.str();
-		}
 	}
 
-	// Calculate the total weight to be sure it's greater than zero
-	double total = boost::accumulate(weights, 0.0);
+	// Sample sources according to their weights, if the total weight
+	// is null then all sources have been exhausted.
+	Source* source = _sources.sample();
 
-	if (total == 0.0) {
+	if (not source) {
 		ure_logger().debug() << msgprfx << "All sources have been exhausted";
 		if (_config.get_retry_exhausted_sources()) {
 			ure_logger().debug() << msgprfx
@@ -350,27 +784,143 @@ Source* ForwardChainer::select_source(const std::string& msgprfx)
 		}
 	}
 
-	// Sample sources according to this distribution
+	// The source is held, thus safe to read
+	LAZY_URE_LOG_FINE << msgprfx << "Sampled source weight: "
+	                  << source->get_weight();
+
+	return source;
+}
+
+/**
+ * Sample and remove a source from a work queue according to the
+ * weights of its sources, dropping and releasing exhausted sources
+ * along the way. The returned source remains held, the hold of the
+ * queue being transferred to the caller. The mutex of the queue is
+ * assumed to be locked.
+ */
+static Source* pop_weighted_source(std::deque<Source*>& queue,
+                                   SourceSet& sources)
+{
+	std::vector<double> weights;
+	for (auto it = queue.begin(); it != queue.end();) {
+		double weight = (*it)->get_weight();
+		if (weight <= 0.0) {
+			sources.release(**it);
+			it = queue.erase(it);
+		} else {
+			weights.push_back(weight);
+			++it;
+		}
+	}
+	if (queue.empty())
+		return nullptr;
+
 	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	return &*std::next(_sources.sources.begin(), dist(randGen()));
+	auto it = std::next(queue.begin(), dist(ure_randgen()));
+	Source* src = *it;
+	queue.erase(it);
+	return src;
+}
+
+Source* ForwardChainer::select_queued_source(int worker,
+                                             const std::string& msgprfx)
+{
+	// Pick from its own queue first
+	WorkQueue& own = *_work_queues[worker];
+	{
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (Source* src = pop_weighted_source(own.sources, _sources))
+			return src;
+	}
+
+	// Otherwise steal from another queue, starting from a random one
+	// to spread thieves over victims
+	size_t n = _work_queues.size();
+	size_t start = ure_randgen().randint(n);
+	for (size_t i = 0; i < n; i++) {
+		size_t victim = (start + i) % n;
+		if (victim == (size_t)worker)
+			continue;
+		WorkQueue& other = *_work_queues[victim];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (Source* src = pop_weighted_source(other.sources, _sources)) {
+			LAZY_URE_LOG_FINE << msgprfx << "Stole source from worker " << victim;
+			return src;
+		}
+	}
+
+	return nullptr;
+}
+
+void ForwardChainer::push_queued_sources(int worker,
+                                         const std::vector<Source*>& srcs)
+{
+	WorkQueue& own = *_work_queues[worker];
+	std::lock_guard<std::mutex> lock(own.mutex);
+	for (Source* src : srcs)
+		own.sources.push_back(src);
+	while (max_work_queue_size < own.sources.size()) {
+		_sources.release(*own.sources.front());
+		own.sources.pop_front();
+	}
+}
+
+RuleUnifications ForwardChainer::unify_source(const Source& source,
+                                              size_t from, size_t to)
+{
+	// Only consider rules with a premise that may structurally match
+	// the source. Meta rules are not indexed as they are forwardly
+	// applied in expand_meta_rules.
+	RuleUnifications unifications;
+	for (size_t i : _premise_index.candidates(source.body)) {
+		if (i < from or to <= i)
+			continue;
+
+		// When searching the focus set, constant clauses are kept
+		// regardless of whether they are in _kb_as, so that
+		// apply_rule may check them against the focus set.
+		const AtomSpace* queried_as = _search_focus_set ? nullptr : &_kb_as;
+
+		// The specializations are interned in the rule table, along
+		// with the rule and premise they come from, so that sources
+		// only keep their ids and do_batch_step may apply them in
+		// bulk. They are not needed in full rule application mode, as
+		// the unaltered rule is applied.
+		bool unified = false;
+		std::vector<RuleTable::RuleId> ids;
+		size_t premises_count = _rules[i].get_premises().size();
+		for (size_t p = 0; p < premises_count; p++) {
+			RuleTypedSubstitutionMap urm = _rules[i].unify_premise(
+				source.body, p, source.vardecl, queried_as);
+			unified = unified or not urm.empty();
+			if (not _config.get_full_rule_application())
+				for (const auto& ur : urm)
+					ids.push_back(_rule_table.intern(ur.first, {i, p}));
+		}
+		if (not unified)
+			continue;
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		unifications.emplace_back(i, std::move(ids));
+	}
+	return unifications;
 }
 
 RuleSet ForwardChainer::get_valid_rules(const Source& source)
 {
-	std::lock_guard<std::mutex> lock(_rules_mutex); // TODO: refine
+	std::shared_lock<std::shared_timed_mutex> lock(_rules_mutex);
+
+	// Get the rules unifying with the source, only unifying the rules
+	// that have not been unified with that source in previous
+	// iterations.
+	RuleUnifications unifications = source.get_unified_rules(
+		_rules.size(), [&](size_t from, size_t to) {
+			return unify_source(source, from, to); });
 
 	// Generate all valid rules
 	RuleSet valid_rules;
-	for (const Rule& rule : _rules) {
-		// For now ignore meta rules as they are forwardly applied in
-		// expand_bit()
-		if (rule.is_meta())
-			continue;
-
-		const AtomSpace& ref_as(_search_focus_set ? _focus_set_as : _kb_as);
-		RuleTypedSubstitutionMap urm =
-			rule.unify_source(source.body, source.vardecl, &ref_as);
-		RuleSet unified_rules = Rule::strip_typed_substitution(urm);
+	for (const auto& unification : unifications) {
+		const Rule& rule = _rules[unification.first];
 
 		// Only insert unexhausted rules for this source
 		RuleSet une_rules;
@@ -378,14 +928,14 @@ RuleSet ForwardChainer::get_valid_rules(const Source& source)
 			// Insert the unaltered rule, which will have the effect of
 			// applying to all sources, not just this one. Convenient for
 			// quickly achieving inference closure albeit expensive.
-			if (not unified_rules.empty() and not source.is_rule_exhausted(rule)) {
+			if (not source.is_rule_exhausted(_rule_table.find(rule))) {
 				une_rules.insert(rule);
 			}
 		} else {
 			// Insert all specializations obtained from the unificiation
-			for (const auto& ur : unified_rules) {
-				if (not source.is_rule_exhausted(ur)) {
-					une_rules.insert(ur);
+			for (RuleTable::RuleId id : unification.second) {
+				if (not source.is_rule_exhausted(id)) {
+					une_rules.insert(_rule_table[id]);
 				}
 			}
 		}
@@ -418,10 +968,8 @@ RuleProbabilityPair ForwardChainer::select_rule(Source& source,
 		LAZY_URE_LOG_DEBUG << ss.str();
 	}
 
-	if (valid_rules.empty()) {
-		source.set_exhausted();
+	if (valid_rules.empty())
 		return RuleProbabilityPair{Rule(), 0.0};
-	}
 
 	return select_rule(valid_rules, msgprfx);
 };
@@ -451,7 +999,7 @@ RuleProbabilityPair ForwardChainer::select_rule(const RuleSet& valid_rules,
 
 	// Sample rules according to the weights
 	std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-	const Rule& selected_rule = rand_element(valid_rules, dist);
+	const Rule& selected_rule = ure_rand_element(valid_rules, dist);
 
 	// Calculate the probability estimate of having this rule fulfill
 	// the objective (required to calculate its complexity)
@@ -460,7 +1008,30 @@ RuleProbabilityPair ForwardChainer::select_rule(const RuleSet& valid_rules,
 	return RuleProbabilityPair{selected_rule, prob};
 }
 
-HandleSet ForwardChainer::apply_rule(const Rule& rule)
+HandleSet ForwardChainer::apply_rule(const Rule& rule, AtomSpace* as)
+{
+	if (not as)
+		as = &_kb_as;
+	AtomSpacePool::Lease derived_rule_as = _scratch_as_pool.borrow();
+	return apply_rule(rule, *derived_rule_as, *as, *as);
+}
+
+HandleSet ForwardChainer::apply_rule(const Rule& rule,
+                                     const std::vector<Source*>& sources,
+                                     size_t premise_index)
+{
+	// Hold the memberships of the sources to the batch in a scratch
+	// atomspace, queried in place of _kb_as, of which it is a child
+	AtomSpacePool::Lease batch_as = _scratch_as_pool.borrow();
+	Handle batch = batch_as->add_node(ANCHOR_NODE, "URE-FC-batch");
+	for (const Source* source : sources)
+		batch_as->add_link(MEMBER_LINK, source->body, batch);
+	return apply_rule(rule.member_premise(premise_index, batch),
+	                  *batch_as, *batch_as, _kb_as);
+}
+
+HandleSet ForwardChainer::apply_rule(const Rule& rule, AtomSpace& rule_as,
+                                     AtomSpace& queried_as, AtomSpace& as)
 {
 	HandleSet results;
 
@@ -484,27 +1055,139 @@ HandleSet ForwardChainer::apply_rule(const Rule& rule)
 	// Wrap in try/catch in case the pattern matcher can't handle it
 	try
 	{
-		AtomSpace& ref_as(_search_focus_set ? _focus_set_as : _kb_as);
-		AtomSpace derived_rule_as(&ref_as);
-		Handle rhcpy = derived_rule_as.add_atom(rule.get_rule());
-
-		// Make Sure that all constant clauses appear in the AtomSpace
-		// as unification might have created constant clauses which aren't
+		// Make Sure that all constant clauses appear in the AtomSpace,
+		// and in the focus set if any, as unification might have
+		// created constant clauses which aren't
 		HandleSeq clauses = rule.get_clauses();
 		const HandleSet& varset = rule.get_variables().varset;
 		for (Handle clause : clauses)
 			if (is_constant(varset, clause))
-				if (ref_as.get_atom(clause) == Handle::UNDEFINED)
+				if (_kb_as.get_atom(clause) == Handle::UNDEFINED
+				    or not in_focus_set(clause))
 					return results;
 
-		Handle h = HandleCast(rhcpy->execute(&_kb_as));
-		add_results(_kb_as, h->getOutgoingSet());
+		Handle rhcpy = rule_as.add_atom(rule.get_rule());
+
+		// Only instantiate the groundings within the focus set, if
+		// any, besides the atoms of rule_as, such as batch
+		// memberships, and stop as soon as the chaining is cancelled
+		RuleImplicator impl(&queried_as);
+		impl.token = std::atomic_load(&_token);
+		if (_search_focus_set)
+			impl.accept = [&](const Handle& h) {
+				return h->getAtomSpace() == &rule_as or in_focus_set(h); };
+		_queries_count++;
+		add_results(as, impl.execute(rhcpy));
 	}
 	catch (...) {}
 
 	return results;
 }
 
+ForwardChainer::SemiNaiveDelta
+ForwardChainer::claim_semi_naive_delta(const Rule& rule)
+{
+	// Get the range of inference records since the last application
+	// of that rule, and move its cursor to the end of it.
+	std::lock_guard<std::mutex> lock(_semi_naive_mutex);
+	SemiNaiveDelta delta;
+	delta.to = _fcstat.size();
+	auto it = _semi_naive_cursors.find(rule.get_rule());
+	delta.first = it == _semi_naive_cursors.end();
+	delta.from = delta.first ? 0 : it->second;
+	_semi_naive_cursors[rule.get_rule()] = delta.to;
+	return delta;
+}
+
+HandleSet ForwardChainer::apply_rule_semi_naive(const Rule& rule)
+{
+	return apply_rule_semi_naive(rule, claim_semi_naive_delta(rule));
+}
+
+HandleSet ForwardChainer::apply_rule_semi_naive(const Rule& rule,
+                                                const SemiNaiveDelta& delta,
+                                                AtomSpace* as)
+{
+	size_t from = delta.from, to = delta.to;
+
+	// First application, apply it over the entire atomspace
+	if (delta.first)
+		return apply_rule(rule, as);
+
+	// Subsequent applications, only apply specializations of the rule
+	// with one premise bound to an atom produced since then, and
+	// within the focus set, if any, as it would not be matched
+	// otherwise.
+	HandleSet new_atoms;
+	for (const Handle& h : _fcstat.get_products(from, to))
+		if (in_focus_set(h))
+			new_atoms.insert(h);
+	LAZY_URE_LOG_DEBUG << "Apply rule " << rule.get_name()
+	                   << " semi-naively over " << new_atoms.size()
+	                   << " new atom(s)";
+
+	// As in unify_source, keep the constant clauses when there is a
+	// focus set, so that apply_rule may check their membership
+	const AtomSpace* queried_as = _search_focus_set ? nullptr : &_kb_as;
+
+	HandleSet results;
+	for (const Handle& h : new_atoms) {
+		// If the chaining has been cancelled, restore the cursor so
+		// that the whole delta is considered by the next application.
+		if (is_cancelled()) {
+			std::lock_guard<std::mutex> lock(_semi_naive_mutex);
+			size_t& cursor = _semi_naive_cursors[rule.get_rule()];
+			cursor = std::min(cursor, from);
+			break;
+		}
+
+		RuleTypedSubstitutionMap urm =
+			rule.unify_source(h, Handle::UNDEFINED, queried_as);
+		for (const Rule& sr : Rule::strip_typed_substitution(urm)) {
+			HandleSet products = apply_rule(sr, as);
+			results.insert(products.begin(), products.end());
+		}
+	}
+	return results;
+}
+
+void ForwardChainer::insert_focus_set(const Handle& h)
+{
+	if (not _focus_set.insert(h).second)
+		return;
+	if (h->is_link())
+		for (const Handle& child : h->getOutgoingSet())
+			insert_focus_set(child);
+}
+
+void ForwardChainer::insert_focus_set(const HandleSet& products)
+{
+	if (not _search_focus_set or products.empty())
+		return;
+	std::lock_guard<std::shared_timed_mutex> lock(_focus_set_mutex);
+	for (const Handle& h : products)
+		insert_focus_set(h);
+}
+
+bool ForwardChainer::in_focus_set(const Handle& h) const
+{
+	if (not _search_focus_set)
+		return true;
+	std::shared_lock<std::shared_timed_mutex> lock(_focus_set_mutex);
+	return _focus_set.find(h) != _focus_set.end();
+}
+
+size_t ForwardChainer::ContentHash::operator()(const Handle& h) const
+{
+	return h.value();
+}
+
+bool ForwardChainer::ContentEqual::operator()(const Handle& lh,
+                                              const Handle& rh) const
+{
+	return content_eq(lh, rh);
+}
+
 void ForwardChainer::validate(const Handle& source)
 {
 	if (source == Handle::UNDEFINED)
@@ -513,14 +1196,33 @@ void ForwardChainer::validate(const Handle& source)
 
 void ForwardChainer::expand_meta_rules(const std::string& msgprfx)
 {
-	std::lock_guard<std::mutex> lock(_rules_mutex);
+	// Meta rules are run over the whole knowledge base the first
+	// time, then only over the products of the inferences recorded
+	// since the previous expansion. Most of the time there are none,
+	// check that under a shared lock first.
+	size_t to = _fcstat.size();
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(_rules_mutex);
+		if (_meta_expanded and to <= _meta_cursor)
+			return;
+	}
+
+	std::lock_guard<std::shared_timed_mutex> lock(_rules_mutex);
 	// This is kinda of hack before meta rules are fully supported by
 	// the Rule class.
 	size_t rules_size = _rules.size();
-	_rules.expand_meta_rules(_kb_as);
+	if (not _meta_expanded) {
+		_rules.expand_meta_rules(_kb_as);
+		_meta_expanded = true;
+	} else if (_meta_cursor < to) {
+		HandleSet new_atoms = _fcstat.get_products(_meta_cursor, to);
+		_rules.expand_meta_rules(_kb_as, new_atoms, _scratch_as_pool);
+	}
+	_meta_cursor = std::max(_meta_cursor, to);
 
 	if (rules_size != _rules.size()) {
 		ure_logger().debug() << msgprfx << "The rule set has gone from "
 		                     << rules_size << " rules to " << _rules.size();
+		_premise_index.insert(_rules, rules_size);
 	}
 }
@@ -24,12 +24,24 @@
 #ifndef _OPENCOG_FORWARDCHAINER_H_
 #define _OPENCOG_FORWARDCHAINER_H_
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
-// #include <shared_mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "../UREConfig.h"
+#include "../ThreadPool.h"
+#include "../AtomSpacePool.h"
+#include "../CancellationToken.h"
 #include "SourceSet.h"
 #include "FCStat.h"
+#include "PremiseIndex.h"
+#include "RuleTable.h"
 
 class ForwardChainerUTest;
 
@@ -87,11 +99,28 @@ public:
 	UREConfig& get_config();
 	const UREConfig& get_config() const;
 
+	/**
+	 * Number of scratch atomspaces allocated so far to hold the rules
+	 * being applied. As they are reused, it is bounded by the number
+	 * of simultaneous rule applications, not the number of
+	 * iterations.
+	 */
+	size_t scratch_atomspaces_allocated() const;
+
 	/**
 	 * Perform forward chaining inference till the termination
-	 * criteria have been met.
+	 * criteria have been met, or the chaining has been cancelled,
+	 * either by cancel or by the given token, if any.
+	 *
+	 * Cancellation is checked before each rule application, in
+	 * semi-naive mode before each specialization of the rule, and on
+	 * each grounding of a rule application in progress, which then
+	 * stops, keeping the conclusions of the groundings found so far.
+	 *
+	 * The given token is only used for that chaining, the chainer
+	 * uses its own token again once it returns.
 	 */
-	void do_chain();
+	void do_chain(const CancellationTokenPtr& token=nullptr);
 
 	/**
 	 * run steps (single or multi threaded) until termination criteria
@@ -100,11 +129,52 @@ public:
 	void do_steps_singlethread();
 	void do_steps_multithread();
 
+	/**
+	 * Run steps multi-threadedly in rounds of jobs iterations. The
+	 * sources and rules of a round are selected in iteration order by
+	 * the calling thread, then the rules are applied in parallel in
+	 * scratch atomspaces, then their results are committed in
+	 * iteration order. Thus the results only depend on the random seed
+	 * and the number of jobs.
+	 */
+	void do_steps_deterministic();
+
 	/**
 	 * Perform a single forward chaining inference step on the given
 	 * iteration.
+	 *
+	 * @param worker index of the worker running the step when
+	 *               multi-threaded, so that it may pick its sources
+	 *               from its local work queue. Negative if
+	 *               single-threaded.
+	 */
+	void do_step(int iteration, int worker=-1);
+
+	/**
+	 * Like do_step but expand up to batch size sources. A rule is
+	 * selected for each source, and sources with the same selected
+	 * rule, up to alpha-conversion, have it applied only once. All
+	 * products are then inserted in the population at once.
+	 *
+	 * In full rule application mode the selected rules are unaltered
+	 * rules. Otherwise they are specialized to their sources, thus
+	 * rarely alpha-equivalent, so constant sources with
+	 * specializations of the same premise of the same rule are merged
+	 * instead, the rule being applied once with that premise bound to
+	 * the members of the group (see Rule::member_premise).
+	 */
+	void do_batch_step(int iteration, int worker, const std::string& msgprfx);
+
+	/**
+	 * Claim the next iteration to run, unless the termination criteria
+	 * have been met. Used by the workers of the multi-threaded
+	 * chainer so that the maximum number of iterations is never
+	 * exceeded.
+	 *
+	 * @return true and set iteration if an iteration has been claimed,
+	 *         false otherwise.
 	 */
-	void do_step(int iteration);
+	bool claim_iteration(int& iteration);
 
 	/**
 	 * @return true if the termination criteria have been met.
@@ -122,6 +192,73 @@ public:
 	Handle get_results() const;
 	HandleSet get_results_set() const;
 
+	/**
+	 * Return the number of distinct results so far. Cheap enough to
+	 * be polled while chaining.
+	 */
+	size_t get_results_size() const;
+
+	/**
+	 * Write the inference steps recorded since the last flush into
+	 * the trace atomspace, if any (see FCStat::flush_trace). The
+	 * chaining already does so every trace_flush_period iterations
+	 * and when it ends, but it may be called from any thread to get
+	 * an up to date trace of an ongoing chaining.
+	 */
+	void flush_trace();
+
+	/**
+	 * Return the distinct results from the from-th one, in order of
+	 * inference. Unlike get_results, no SetLink is added to the
+	 * knowledge base. To poll new results while chaining, pass the
+	 * number of results obtained so far.
+	 */
+	HandleSeq get_results_seq(size_t from=0) const;
+
+	/**
+	 * Callback called on each new product, as soon as it is produced
+	 * by a rule application. It returns false to cancel the chaining,
+	 * true to carry on.
+	 */
+	typedef std::function<bool(const Handle&)> ResultCallback;
+
+	/**
+	 * Subscribe a callback to the products of the chaining. Callbacks
+	 * are called under a mutex, so they need not be thread safe even
+	 * if the chainer is multi-threaded, but they should be fast as
+	 * they block the chaining meanwhile.
+	 */
+	void subscribe(const ResultCallback& callback);
+
+	/**
+	 * Like above, but the callback is the evaluation of the given
+	 * predicate, typically a GroundedPredicateNode, over the product
+	 *
+	 * EvaluationLink
+	 *   <predicate>
+	 *   ListLink
+	 *     <product>
+	 *
+	 * The chaining is cancelled if it evaluates to a TV with a mean
+	 * below 0.5.
+	 */
+	void subscribe(const Handle& predicate);
+
+	/**
+	 * Cancel the chaining, which terminates once the rule
+	 * applications in progress reach their next grounding. This
+	 * cancels the token of the chaining, that is the one passed to
+	 * do_chain, if any.
+	 */
+	void cancel();
+
+	/**
+	 * Return true iff the token of the chaining has been cancelled,
+	 * either by cancel, or by the owner of the token passed to
+	 * do_chain.
+	 */
+	bool is_cancelled() const;
+
 private:
 	friend class ::ForwardChainerUTest;
 
@@ -131,6 +268,10 @@ private:
 
 	void apply_all_rules();
 
+	// Pass the products to the subscribers, and cancel the chaining
+	// if any of them says so.
+	void notify(const HandleSet& products);
+
 	void validate(const Handle& source);
 
 	/**
@@ -150,9 +291,43 @@ private:
 	 */
 	Source* select_source(const std::string& msgprfx);
 
+	/**
+	 * Select a source from the work queue of the worker if any,
+	 * otherwise from the whole population. The source is held and
+	 * must be released.
+	 */
+	Source* select_any_source(int worker, const std::string& msgprfx);
+
+	/**
+	 * Select a source from the work queue of the given worker, or if
+	 * empty, steal one from the work queue of another worker. Within
+	 * a queue, sources are sampled according to their weights.
+	 *
+	 * @return A Source to expand, or nullptr if all queues are empty,
+	 *         in which case the source should be selected from the
+	 *         whole population with select_source.
+	 */
+	Source* select_queued_source(int worker, const std::string& msgprfx);
+
+	/**
+	 * Push new sources to the work queue of the given worker.
+	 */
+	void push_queued_sources(int worker, const std::vector<Source*>& srcs);
+
+	/**
+	 * Unify the source with the rules at positions [from, to) of the
+	 * rule set, interning the resulting specializations in the rule
+	 * table. _rules_mutex is assumed to be locked.
+	 */
+	RuleUnifications unify_source(const Source& source,
+	                              size_t from, size_t to);
+
 	/**
 	 * Get rules that unify with the source and that are not exhausted,
 	 * which include rules currently being run.
+	 *
+	 * Unifications are cached in the source, so that the source is
+	 * only unified with each rule once, see Source::get_unified_rules.
 	 */
 	RuleSet get_valid_rules(const Source& source);
 
@@ -174,45 +349,239 @@ private:
 	                                const std::string& msgprfx="");
 
 	/**
-	 * Apply rule.
+	 * Apply rule, adding its products to as, which must be a child of
+	 * _kb_as, or to _kb_as if as is null. If there is a focus set,
+	 * only the groundings within it are considered.
+	 */
+	HandleSet apply_rule(const Rule& rule, AtomSpace* as=nullptr);
+
+	/**
+	 * Apply rule once over all given constant sources, bound to its
+	 * premise of the given index, adding its products to _kb_as. That
+	 * is the same as applying the specializations of that premise
+	 * over each source, in a single query.
+	 */
+	HandleSet apply_rule(const Rule& rule, const std::vector<Source*>& sources,
+	                     size_t premise_index);
+
+	/**
+	 * Apply rule, copied into rule_as, by querying queried_as, and add
+	 * its products to as. The atoms of rule_as are not subject to the
+	 * focus set.
+	 */
+	HandleSet apply_rule(const Rule& rule, AtomSpace& rule_as,
+	                     AtomSpace& queried_as, AtomSpace& as);
+
+	/**
+	 * Range of inference records whose products a rule is to be
+	 * applied over in semi-naive mode. first is true if it is the
+	 * first application of that rule.
+	 */
+	struct SemiNaiveDelta
+	{
+		bool first = true;
+		size_t from = 0;
+		size_t to = 0;
+	};
+
+	/**
+	 * Return the range of inference records since the last
+	 * application of the rule, and move its cursor to the end of it.
+	 */
+	SemiNaiveDelta claim_semi_naive_delta(const Rule& rule);
+
+	/**
+	 * Semi-naive counterpart of apply_rule, for full rule
+	 * application. The first time a rule is applied it is applied
+	 * over the entire atomspace. Subsequent times it is only applied
+	 * over the atoms produced since its last application, by
+	 * specializing it so that one of its premises is bound to such
+	 * atom.
+	 */
+	HandleSet apply_rule_semi_naive(const Rule& rule);
+	HandleSet apply_rule_semi_naive(const Rule& rule,
+	                                const SemiNaiveDelta& delta,
+	                                AtomSpace* as=nullptr);
+
+	/**
+	 * Single forward chaining step, split into the selection of its
+	 * source and rule, the application of its rule, and the commit of
+	 * its results, so that the multi-threaded chainer may order them.
+	 */
+	struct Step
+	{
+		Step(int iteration);
+
+		int iteration;
+		std::string msgprfx;
+
+		// Selected source, held till the end of the step
+		Source* source;
+		std::unique_ptr<SourceSet::ReleaseGuard> guard;
+
+		// Selected rule, and its probability of success
+		Rule rule;
+		double prob;
+		Source::RuleId rule_id;
+		SemiNaiveDelta delta;
+
+		// Scratch atomspace holding the products till they are
+		// committed, if any
+		std::unique_ptr<AtomSpacePool::Lease> lease;
+
+		HandleSet products;
+	};
+
+	/**
+	 * Select the source and rule of the step. Return false if the
+	 * iteration should be aborted.
 	 */
-	HandleSet apply_rule(const Rule& rule);
+	bool select_step(Step& step, int worker);
+
+	/**
+	 * Apply the rule of the step, adding its products to as, or to
+	 * _kb_as if null.
+	 */
+	void apply_step(Step& step, AtomSpace* as=nullptr);
+
+	/**
+	 * Copy the products of the step to _kb_as if needed, insert them
+	 * in the population and record them.
+	 */
+	void commit_step(Step& step, int worker);
 
 	RuleSet _rules; /* loaded rules */
 
+	// Index of the rule premises, to only unify sources with rules
+	// they may structurally match.
+	PremiseIndex _premise_index;
+
+	// Rules applied on sources, up to alpha-equivalence, so that
+	// sources only need to keep their ids.
+	RuleTable _rule_table;
+
 	// Knowledge base atomspace
 	AtomSpace& _kb_as;
 
 	// Rule base atomspace (can be the same as _kb_as)
 	AtomSpace& _rb_as;
 
-	// The focus set is copied into this atomspace; during chaining,
-	// the pattern matcher is applied only to this atomspace.  This
-	// is the primary mechanism by which chaining is restricted to
-	// the focus set.  This is effective, but not very efficient;
-	// perhaps there is some better mechanism?
-	AtomSpace _focus_set_as;
+	// Scratch atomspaces, children of _kb_as, to hold the rules being
+	// applied.
+	AtomSpacePool _scratch_as_pool;
+
+	// Atoms of the focus set, the initial sources and the products,
+	// as well as their subatoms, compared by content. It is a
+	// membership filter over _kb_as, used to restrict rule
+	// unification and application to the focus set, without copying
+	// any atom.
+	struct ContentHash
+	{
+		size_t operator()(const Handle& h) const;
+	};
+	struct ContentEqual
+	{
+		bool operator()(const Handle& lh, const Handle& rh) const;
+	};
+	std::unordered_set<Handle, ContentHash, ContentEqual> _focus_set;
+
+	// Protect _focus_set, shared while applying rules, exclusive
+	// while inserting products.
+	mutable std::shared_timed_mutex _focus_set_mutex;
+
+	// Insert h and its subatoms in _focus_set. _focus_set_mutex is
+	// assumed to be locked.
+	void insert_focus_set(const Handle& h);
+
+	// Insert the products of an inference in _focus_set, if there is
+	// a focus set, so that they may be used as premises by further
+	// inferences.
+	void insert_focus_set(const HandleSet& products);
+
+	// Return true iff h is in the focus set, or if there is no focus
+	// set.
+	bool in_focus_set(const Handle& h) const;
 
 	UREConfig _config;
 
 	// Current iteration
 	std::atomic<int> _iteration;
 
+	// Number of pattern matcher queries run to apply rules
+	std::atomic<size_t> _queries_count;
+
 	bool _search_focus_set;
 
 	// TODO: subdivide in smaller and shared mutexes
 	mutable std::mutex _whole_mutex;
 	mutable std::mutex _part_mutex;
 
-	// TODO: use shared mutexes
-	mutable std::mutex _rules_mutex;
+	// Protect _rules, shared while unifying rules to sources,
+	// exclusive while expanding meta rules.
+	mutable std::shared_timed_mutex _rules_mutex;
 
-	// Keep track of the number of threads to make sure
-	std::atomic<int> _thread_count;
+	// Whether meta rules have been expanded over the whole knowledge
+	// base, and the number of inference records whose products they
+	// have been expanded over since. Protected by _rules_mutex.
+	bool _meta_expanded;
+	size_t _meta_cursor;
+
+	// Map each rule fully applied in semi-naive mode to the number of
+	// inference records of _fcstat at its last application, so that
+	// the products since then can be retrieved.
+	std::unordered_map<Handle, size_t> _semi_naive_cursors;
+	std::mutex _semi_naive_mutex;
+
+	// Workers running the steps of the multi-threaded chainer. They
+	// are created on first use and live as long as the chainer.
+	ThreadPool _pool;
 
 	// Population of sources to expand forward
 	SourceSet _sources;
 
+	// Callbacks called on each new product
+	std::vector<ResultCallback> _subscribers;
+	std::mutex _subscribers_mutex;
+
+	// Token of the chaining, the one passed to do_chain if any during
+	// that chaining, otherwise owned by the chainer. Accessed
+	// atomically, as cancel may be called from any thread.
+	CancellationTokenPtr _token;
+
+	// Start time and knowledge base size at the start of the
+	// chaining, to check the budgets.
+	std::chrono::steady_clock::time_point _start_time;
+	size_t _start_kb_size;
+
+	// Return the cause of termination if a budget has been exceeded,
+	// the empty string otherwise.
+	std::string exceeded_budget() const;
+
+	// Work queue of a worker, holding the sources it has recently
+	// produced. A worker picks its next source from its own queue,
+	// steals from other queues when its own is empty, and falls back
+	// to sampling the whole population when all are empty. This
+	// avoids having all workers contend on select_source.
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Source*> sources;
+	};
+	std::vector<std::unique_ptr<WorkQueue>> _work_queues;
+
+	// Maximum number of sources held by a work queue. The oldest are
+	// dropped beyond that, which is harmless as they remain in the
+	// population.
+	static const size_t max_work_queue_size;
+
+	// Number of iterations between two flushes of the trace during
+	// the chaining.
+	static const int trace_flush_period;
+
+	// Flush the trace if the given iteration ends a flush period. To
+	// be called once the iteration has been committed.
+	void flush_trace(int iteration);
+
 	FCStat _fcstat;
 };
 
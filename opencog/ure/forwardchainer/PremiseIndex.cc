@@ -0,0 +1,114 @@
+/*
+ * PremiseIndex.cc
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "PremiseIndex.h"
+
+#include <algorithm>
+
+#include <opencog/atoms/core/Quotation.h>
+
+using namespace opencog;
+
+void PremiseIndex::insert(size_t rule_index, const Rule& rule)
+{
+	if (rule.is_meta())
+		return;
+
+	const HandleSet& varset = rule.get_variables().varset;
+	for (const Handle& premise : rule.get_premises()) {
+		if (is_wildcard(premise, varset)) {
+			_wildcards.push_back(rule_index);
+		} else {
+			Entry entry{rule_index, arity(premise), has_glob_child(premise)};
+			_by_type[premise->get_type()].push_back(entry);
+		}
+	}
+	_size++;
+}
+
+void PremiseIndex::insert(const RuleSet& rules, size_t from)
+{
+	for (size_t i = from; i < rules.size(); i++)
+		insert(i, rules[i]);
+}
+
+std::vector<size_t> PremiseIndex::candidates(const Handle& source) const
+{
+	std::vector<size_t> results(_wildcards);
+	Type st = source->get_type();
+
+	if (st == VARIABLE_NODE or st == GLOB_NODE or
+	    Quotation::is_quotation_type(st)) {
+		// The source may match any premise
+		for (const auto& te : _by_type)
+			for (const Entry& entry : te.second)
+				results.push_back(entry.rule_index);
+	} else {
+		auto it = _by_type.find(st);
+		if (it != _by_type.end()) {
+			Arity sa = arity(source);
+			bool sg = has_glob_child(source);
+			for (const Entry& entry : it->second)
+				if (sg or entry.has_glob or sa == entry.arity)
+					results.push_back(entry.rule_index);
+		}
+	}
+
+	// Remove duplicates, and keep the order of the rule set
+	std::sort(results.begin(), results.end());
+	results.erase(std::unique(results.begin(), results.end()), results.end());
+	return results;
+}
+
+void PremiseIndex::clear()
+{
+	_wildcards.clear();
+	_by_type.clear();
+	_size = 0;
+}
+
+size_t PremiseIndex::size() const
+{
+	return _size;
+}
+
+Arity PremiseIndex::arity(const Handle& h)
+{
+	return h->is_link() ? h->get_arity() : 0;
+}
+
+bool PremiseIndex::has_glob_child(const Handle& h)
+{
+	if (not h->is_link())
+		return false;
+	for (const Handle& child : h->getOutgoingSet())
+		if (child->get_type() == GLOB_NODE)
+			return true;
+	return false;
+}
+
+bool PremiseIndex::is_wildcard(const Handle& premise, const HandleSet& varset)
+{
+	Type pt = premise->get_type();
+	return varset.find(premise) != varset.end()
+		or pt == VARIABLE_NODE or pt == GLOB_NODE
+		or Quotation::is_quotation_type(pt);
+}
@@ -0,0 +1,110 @@
+/*
+ * PremiseIndex.h
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_PREMISEINDEX_H_
+#define _OPENCOG_PREMISEINDEX_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/ure/Rule.h>
+
+namespace opencog {
+
+/**
+ * Index of the rules of a rule set by the type and arity signatures
+ * of their premises, used by the forward chainer to only unify a
+ * source against rules that have a premise which could structurally
+ * match it.
+ *
+ * The filter is conservative, a rule is a candidate if one of its
+ * premises
+ *
+ * 1. is a variable, a glob or a quotation, or
+ *
+ * 2. has the same type as the source, and the same arity, unless the
+ *    premise or the source has a glob as immediate child.
+ *
+ * Sources that are variables or globs match all rules.
+ */
+class PremiseIndex
+{
+public:
+	/**
+	 * Index the premises of the given rule, which is at position
+	 * rule_index in the rule set. Meta rules are ignored.
+	 */
+	void insert(size_t rule_index, const Rule& rule);
+
+	/**
+	 * Index the rules from position from to the end of the rule set.
+	 */
+	void insert(const RuleSet& rules, size_t from=0);
+
+	/**
+	 * Return the positions, in increasing order, of the rules that
+	 * may have a premise unifying with source.
+	 */
+	std::vector<size_t> candidates(const Handle& source) const;
+
+	/**
+	 * Remove all entries.
+	 */
+	void clear();
+
+	/**
+	 * Number of indexed rules.
+	 */
+	size_t size() const;
+
+private:
+	// Premise signature of a rule, its type is the key of _by_type
+	struct Entry
+	{
+		size_t rule_index;
+		Arity arity;
+		bool has_glob;
+	};
+
+	// Return the arity of h, 0 if it is a node
+	static Arity arity(const Handle& h);
+
+	// Return true iff h has a glob as immediate child
+	static bool has_glob_child(const Handle& h);
+
+	// Return true iff a premise with that signature would match
+	// anything
+	static bool is_wildcard(const Handle& premise, const HandleSet& varset);
+
+	// Rules with a premise matching anything
+	std::vector<size_t> _wildcards;
+
+	// Rules indexed by the types of their premises
+	std::unordered_map<Type, std::vector<Entry>> _by_type;
+
+	// Number of indexed rules
+	size_t _size = 0;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_PREMISEINDEX_H_ */
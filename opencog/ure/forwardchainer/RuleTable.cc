@@ -0,0 +1,90 @@
+/*
+ * RuleTable.cc
+ *
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "RuleTable.h"
+
+#include <mutex>
+
+using namespace opencog;
+
+const RuleTable::RuleId RuleTable::npos =
+	std::numeric_limits<RuleTable::RuleId>::max();
+
+bool RuleTable::Origin::is_known() const
+{
+	return rule != std::numeric_limits<size_t>::max();
+}
+
+RuleTable::RuleId RuleTable::intern(const Rule& rule, const Origin& origin)
+{
+	size_t hash = rule.get_rule().value();
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+		RuleId id = find_locked(rule, hash);
+		if (id != npos)
+			return id;
+	}
+
+	std::lock_guard<std::shared_timed_mutex> lock(_mutex);
+	// Another thread may have inserted it meanwhile
+	RuleId id = find_locked(rule, hash);
+	if (id != npos)
+		return id;
+	id = _rules.size();
+	_rules.push_back(rule);
+	_origins.push_back(origin);
+	_index.emplace(hash, id);
+	return id;
+}
+
+RuleTable::RuleId RuleTable::find(const Rule& rule) const
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+	return find_locked(rule, rule.get_rule().value());
+}
+
+const Rule& RuleTable::operator[](RuleId id) const
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+	return _rules[id];
+}
+
+RuleTable::Origin RuleTable::origin(RuleId id) const
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+	return _origins[id];
+}
+
+size_t RuleTable::size() const
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+	return _rules.size();
+}
+
+RuleTable::RuleId RuleTable::find_locked(const Rule& rule, size_t hash) const
+{
+	auto range = _index.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+		if (rule.is_alpha_equivalent(_rules[it->second]))
+			return it->second;
+	return npos;
+}
@@ -0,0 +1,112 @@
+/*
+ * RuleTable.h
+ *
+ *
+ * Copyright (C) 2020 OpenCog Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_RULETABLE_H_
+#define _OPENCOG_RULETABLE_H_
+
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <opencog/ure/Rule.h>
+
+namespace opencog {
+
+/**
+ * Table of rules, up to alpha-equivalence, shared by all sources of a
+ * forward chainer, so that sources can refer to the rules tried on
+ * them by id rather than holding copies of them.
+ *
+ * Rules are hashed by their alpha-invariant atom hash, then compared
+ * with Rule::is_alpha_equivalent. Rules are never removed, and their
+ * address is stable.
+ */
+class RuleTable
+{
+public:
+	typedef unsigned RuleId;
+
+	/**
+	 * Id returned by find when the rule is not in the table.
+	 */
+	static const RuleId npos;
+
+	/**
+	 * Where a specialization comes from: the index of the rule it
+	 * specializes, and the index of the premise unified with the
+	 * source. Both are npos if unknown.
+	 */
+	struct Origin
+	{
+		Origin(size_t rule=std::numeric_limits<size_t>::max(),
+		       size_t premise=std::numeric_limits<size_t>::max())
+			: rule(rule), premise(premise) {}
+
+		bool is_known() const;
+
+		size_t rule;
+		size_t premise;
+	};
+
+	/**
+	 * Return the id of the rule alpha-equivalent to the given rule,
+	 * inserting it if there is none, along with its origin.
+	 */
+	RuleId intern(const Rule& rule, const Origin& origin=Origin());
+
+	/**
+	 * Return the id of the rule alpha-equivalent to the given rule, or
+	 * npos if there is none.
+	 */
+	RuleId find(const Rule& rule) const;
+
+	/**
+	 * Return the rule with the given id.
+	 */
+	const Rule& operator[](RuleId id) const;
+
+	/**
+	 * Return the origin of the rule with the given id, as provided
+	 * when it was first interned.
+	 */
+	Origin origin(RuleId id) const;
+
+	size_t size() const;
+
+private:
+	// Return the id of rule, or npos, assuming _mutex is locked
+	RuleId find_locked(const Rule& rule, size_t hash) const;
+
+	// Deque, so that references to rules remain valid on insertion
+	std::deque<Rule> _rules;
+	std::deque<Origin> _origins;
+
+	// Map the hash of rules to their ids
+	std::unordered_multimap<size_t, RuleId> _index;
+
+	mutable std::shared_timed_mutex _mutex;
+};
+
+} // ~namespace opencog
+
+#endif /* _OPENCOG_RULETABLE_H_ */
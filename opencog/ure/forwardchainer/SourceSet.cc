@@ -22,12 +22,16 @@
 
 #include "SourceSet.h"
 
-#include <boost/range/algorithm/binary_search.hpp>
-#include <boost/range/algorithm/lower_bound.hpp>
+#include <algorithm>
+#include <array>
 
 #include <opencog/util/numeric.h>
+#include <opencog/util/oc_assert.h>
+#include <opencog/util/random.h>
 #include <opencog/atoms/core/VariableSet.h>
 
+#include "../URERandGen.h"
+
 namespace opencog {
 
 double calculate_weight(const Handle& bdy, double cpx_fctr)
@@ -49,7 +53,11 @@ Source::Source(const Handle& bdy, const Handle& vdcl, double cpx, double cpx_fct
 	  complexity(cpx),
 	  complexity_factor(cpx_fctr),
 	  weight(calculate_weight(bdy, cpx_fctr)),
-	  exhausted(false)
+	  exhausted(false),
+	  index(0),
+	  initial(false),
+	  holders(0),
+	  _unified_rules_size(0)
 {
 }
 
@@ -65,46 +73,84 @@ bool Source::operator<(const Source& other) const
 		or (content_eq(body, other.body) and vardecl < other.vardecl);
 }
 
-bool Source::insert_rule(const Rule& rule)
+// Insert id in the sorted vector ids, return false if already there
+static bool insert_sorted(std::vector<RuleTable::RuleId>& ids,
+                          RuleTable::RuleId id)
 {
-	std::lock_guard<std::mutex> lock(_mutex);
-	return rules.insert(rule);
+	auto it = std::lower_bound(ids.begin(), ids.end(), id);
+	if (it != ids.end() and *it == id)
+		return false;
+	ids.insert(it, id);
+	return true;
+}
+
+bool Source::insert_rule(RuleId rule)
+{
+	std::lock_guard<std::mutex> lock(get_mutex());
+	return insert_sorted(rules, rule);
 }
 
 void Source::set_exhausted()
 {
-	std::lock_guard<std::mutex> lock(_mutex);
+	std::lock_guard<std::mutex> lock(get_mutex());
 	exhausted = true;
 }
 
 void Source::reset_exhausted()
 {
-	std::lock_guard<std::mutex> lock(_mutex);
+	std::lock_guard<std::mutex> lock(get_mutex());
 	exhausted = false;
 	rules.clear();
+	exhausted_rules.clear();
 }
 
 bool Source::is_exhausted() const
 {
-	std::lock_guard<std::mutex> lock(_mutex);
+	std::lock_guard<std::mutex> lock(get_mutex());
 	return exhausted;
 }
 
-void Source::set_rule_exhausted(const Rule& rule)
+void Source::set_rule_exhausted(RuleId rule)
 {
-	std::lock_guard<std::mutex> lock(_mutex);
-	for (Rule& r : rules)
-		if (rule.is_alpha_equivalent(r))
-			r.set_exhausted();
+	std::lock_guard<std::mutex> lock(get_mutex());
+	if (std::binary_search(rules.begin(), rules.end(), rule))
+		insert_sorted(exhausted_rules, rule);
 }
 
-bool Source::is_rule_exhausted(const Rule& rule) const
+bool Source::is_rule_exhausted(RuleId rule) const
 {
-	std::lock_guard<std::mutex> lock(_mutex);
-	for (const Rule& r : rules)
-		if (rule.is_alpha_equivalent(r) and r.is_exhausted())
-			return true;
-	return false;
+	std::lock_guard<std::mutex> lock(get_mutex());
+	return std::binary_search(exhausted_rules.begin(),
+	                          exhausted_rules.end(), rule);
+}
+
+RuleUnifications Source::get_unified_rules(size_t rules_size,
+                                           const Unifier& unify) const
+{
+	std::unique_lock<std::mutex> lock(get_mutex());
+	while (_unified_rules_size < rules_size) {
+		// Unification is costly, do not hold the mutex meanwhile as
+		// it is shared with other sources.
+		size_t from = _unified_rules_size;
+		lock.unlock();
+		RuleUnifications new_urs = unify(from, rules_size);
+		lock.lock();
+
+		// Unless another thread has unified them meanwhile
+		if (_unified_rules_size == from) {
+			_unified_rules.insert(_unified_rules.end(),
+			                      new_urs.begin(), new_urs.end());
+			_unified_rules_size = rules_size;
+		}
+	}
+	return _unified_rules;
+}
+
+std::mutex& Source::get_mutex() const
+{
+	static std::array<std::mutex, 64> mutexes;
+	size_t i = std::hash<const Source*>()(this) / sizeof(Source);
+	return mutexes[i % mutexes.size()];
 }
 
 double Source::expand_complexity(double prob) const
@@ -121,7 +167,7 @@ double Source::get_weight() const
 
 std::string Source::to_string(const std::string& indent) const
 {
-	std::lock_guard<std::mutex> lock(_mutex);
+	std::lock_guard<std::mutex> lock(get_mutex());
 	std::stringstream ss;
 	ss << indent << "body:" << std::endl
 	   << oc_to_string(body, indent + oc_to_string_indent) << std::endl
@@ -129,8 +175,12 @@ std::string Source::to_string(const std::string& indent) const
 	   << oc_to_string(vardecl, indent + oc_to_string_indent) << std::endl
 	   << indent << "complexity: " << complexity << std::endl
 	   << indent << "exhausted: " <<  exhausted << std::endl
-	   << indent << "rules:" << std::endl
-	   << rules.to_short_string(indent + oc_to_string_indent);
+	   << indent << "rules:";
+	for (RuleId id : rules)
+		ss << " " << id;
+	ss << std::endl << indent << "exhausted rules:";
+	for (RuleId id : exhausted_rules)
+		ss << " " << id;
 	return ss.str();
 }
 
@@ -147,10 +197,9 @@ SourceSet::SourceSet(const UREConfig& config,
 			exhausted = true;
 		} else {
 			for (const Handle& src : init_sources) {
-				auto ptr_less = [](const Source& ls, const Source* rs) {
-					return ls < *rs; };
-				Source* new_src = new Source(src, init_vardecl);
-				sources.insert(boost::lower_bound(sources, new_src, ptr_less), new_src);
+				Source* init_src = new Source(src, init_vardecl);
+				init_src->initial = true;
+				add(init_src);
 			}
 		}
 	} else {
@@ -173,6 +222,13 @@ void SourceSet::set_exhausted()
 	exhausted = true;
 }
 
+void SourceSet::set_exhausted(Source& src)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	src.set_exhausted();
+	_sampler.set(src.index, 0.0);
+}
+
 void SourceSet::reset_exhausted()
 {
 	std::lock_guard<std::mutex> lock(_mutex);
@@ -181,8 +237,10 @@ void SourceSet::reset_exhausted()
 		return;
 	}
 
-	for (Source& src : sources)
+	for (Source& src : sources) {
 		src.reset_exhausted();
+		_sampler.set(src.index, src.get_weight());
+	}
 	exhausted = false;
 }
 
@@ -192,45 +250,184 @@ bool SourceSet::is_exhausted() const
 	return exhausted;
 }
 
-void SourceSet::insert(const HandleSet& products, const Source& src,
-                       double prob, const std::string& msgprfx)
+Source* SourceSet::sample()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_sampler.total() <= 0.0)
+		return nullptr;
+	Source* src = &sources[_sampler.sample(ure_randgen())];
+	src->holders++;
+	return src;
+}
+
+void SourceSet::release(Source& src)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	OC_ASSERT(0 < src.holders);
+	src.holders--;
+}
+
+SourceSet::ReleaseGuard::ReleaseGuard(SourceSet& sources, Source& src)
+	: _sources(sources), _src(src) {}
+
+SourceSet::ReleaseGuard::~ReleaseGuard()
+{
+	_sources.release(_src);
+}
+
+size_t SourceSet::SourceHash::operator()(const Source* src) const
+{
+	return src->body.value();
+}
+
+bool SourceSet::SourceEqual::operator()(const Source* ls, const Source* rs) const
+{
+	return content_eq(ls->body, rs->body) and ls->vardecl == rs->vardecl;
+}
+
+void SourceSet::add(Source* new_src)
+{
+	new_src->index = sources.size();
+	sources.push_back(new_src);
+	_index.insert(new_src);
+	_sampler.push_back(new_src->get_weight());
+}
+
+void SourceSet::remove(Source* src)
+{
+	size_t i = src->index, last = sources.size() - 1;
+	_index.erase(src);
+	if (i != last) {
+		// Move the last source in place of src, which is deleted
+		Sources::auto_type moved = sources.pop_back();
+		moved->index = i;
+		_sampler.set(i, _sampler.get(last));
+		sources.replace(i, moved.release());
+	} else {
+		sources.pop_back();
+	}
+	_sampler.pop_back();
+}
+
+std::unordered_set<const Source*> SourceSet::evict(const std::string& msgprfx)
+{
+	int max_size = _config.get_maximum_source_set_size();
+	if (max_size < 0 or sources.size() <= (size_t)max_size)
+		return {};
+
+	// Evict down to a low-water mark, rather than one source per
+	// insertion, to amortize the cost of selecting them.
+	size_t target = (size_t)max_size - (size_t)max_size / 10;
+	size_t count = sources.size() - target;
+
+	// Select the count least promising evictable sources, using a
+	// max-heap holding the least promising ones so far, in
+	// O(n log count).
+	typedef std::pair<double, Source*> WeightedSource;
+	std::vector<WeightedSource> heap;
+	for (Source& src : sources) {
+		if (src.initial or 0 < src.holders)
+			continue;
+		WeightedSource ws(src.get_weight(), &src);
+		if (heap.size() < count) {
+			heap.push_back(ws);
+			std::push_heap(heap.begin(), heap.end());
+		} else if (ws < heap.front()) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = ws;
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+
+	std::unordered_set<const Source*> evicted;
+	for (const WeightedSource& ws : heap) {
+		evicted.insert(ws.second);
+		remove(ws.second);
+	}
+
+	LAZY_URE_LOG_DEBUG << msgprfx << "Evicted " << evicted.size()
+	                   << " sources, population size is now "
+	                   << sources.size();
+	return evicted;
+}
+
+std::vector<Source*> SourceSet::insert(const HandleSet& products,
+                                       const Source& src,
+                                       double prob,
+                                       const std::string& msgprfx,
+                                       bool hold)
 {
 	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<Source*> new_srcs;
+	add_products(products, src, prob, hold, new_srcs, msgprfx);
+	evict_and_log(new_srcs, products.size(), msgprfx);
+	return new_srcs;
+}
+
+std::vector<Source*> SourceSet::insert(const std::vector<Production>& productions,
+                                       const std::string& msgprfx,
+                                       bool hold)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<Source*> new_srcs;
+	size_t products_size = 0;
+	for (const Production& prod : productions) {
+		add_products(prod.products, *prod.source, prod.prob, hold,
+		             new_srcs, msgprfx);
+		products_size += prod.products.size();
+	}
+	evict_and_log(new_srcs, products_size, msgprfx);
+	return new_srcs;
+}
+
+void SourceSet::add_products(const HandleSet& products, const Source& src,
+                             double prob, bool hold,
+                             std::vector<Source*>& new_srcs,
+                             const std::string& msgprfx)
+{
 	const static Handle empty_variable_set = Handle(createVariableSet(HandleSeq()));
 
 	// Calculate the complexity of the new sources
 	double new_cpx = src.expand_complexity(prob);
 	double new_cpx_fctr = exp(-_config.get_complexity_penalty() * new_cpx);
 
-	// Keep all new sources
-	std::vector<Source*> new_srcs;
+	// Insert all new sources
 	for (const Handle& product : products) {
 		Source* new_src = new Source(product, empty_variable_set,
 		                             new_cpx, new_cpx_fctr);
 
 		// Make sure it isn't already in the sources
-		if (boost::binary_search(sources, *new_src)) {
+		if (_index.find(new_src) != _index.end()) {
 			LAZY_URE_LOG_FINE << msgprfx
 			                  << "The following source is already in the population: "
 			                  << new_src->body->id_to_string();
 			delete new_src;
 		} else {
+			if (hold)
+				new_src->holders++;
+			add(new_src);
 			new_srcs.push_back(new_src);
 		}
 	}
+}
 
-	// Insert all new sources
-	for (Source* new_src : new_srcs) {
-		// Insert it while preserving the order
-		auto ptr_less = [](const Source& ls, const Source* rs) {
-			return ls < *rs; };
-		sources.insert(boost::lower_bound(sources, new_src, ptr_less), new_src);
-	}
+void SourceSet::evict_and_log(std::vector<Source*>& new_srcs,
+                              size_t products_size,
+                              const std::string& msgprfx)
+{
+	// Evict sources if the population has become too large, and
+	// remove them from the new sources.
+	std::unordered_set<const Source*> evicted = evict(msgprfx);
+	if (not evicted.empty())
+		new_srcs.erase(std::remove_if(new_srcs.begin(), new_srcs.end(),
+		                              [&](const Source* s) {
+			                              return evicted.count(s); }),
+		               new_srcs.end());
 
 	// Log the new sources
 	if (ure_logger().is_debug_enabled()) {
 		LAZY_URE_LOG_DEBUG << msgprfx
-		                   << products.size() << " results, including "
+		                   << products_size << " results, including "
 		                   << new_srcs.size() << " new sources";
 		HandleSeq new_src_bodies;
 		for (const Source* new_src : new_srcs)
@@ -24,8 +24,10 @@
 #ifndef _OPENCOG_SOURCESET_H_
 #define _OPENCOG_SOURCESET_H_
 
+#include <functional>
 #include <vector>
 #include <mutex>
+#include <unordered_set>
 
 #include <boost/operators.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -34,11 +36,22 @@
 #include <opencog/atoms/base/Handle.h>
 
 #include "../Rule.h"
+#include "../SumTree.h"
 #include "../UREConfig.h"
+#include "RuleTable.h"
 
 namespace opencog
 {
 
+/**
+ * Rules unifying with a source, as pairs of the position of the rule
+ * in the forward chainer rule set, and the ids, in the forward
+ * chainer rule table, of the specializations of that rule obtained by
+ * unification.
+ */
+typedef std::vector<std::pair<size_t, std::vector<RuleTable::RuleId>>>
+	RuleUnifications;
+
 /**
  * Each source is associated to
  *
@@ -47,7 +60,8 @@ namespace opencog
  * 2. a complexity (reflecting the probability that expanding it will
  *    fulfill the objective),
  *
- * 3. the set of rules that have expanded it so far,
+ * 3. the set of rules that have expanded it so far, as ids of the
+ *    forward chainer rule table,
  *
  * 4. a flag call indicating if the source expansions have been exhausted.
  */
@@ -68,12 +82,14 @@ public:
 	bool operator==(const Source& other) const;
 	bool operator<(const Source& other) const;
 
+	typedef RuleTable::RuleId RuleId;
+
 	/**
-	 * Insert rule in the rule set to remember it is being
-	 * applied. Return true if insertion is successful (that is if no
-	 * alpha-equivalent rule was already there).
+	 * Insert the id of a rule to remember it is being applied. Return
+	 * true if insertion is successful (that is if the rule was not
+	 * already there).
 	 */
-	bool insert_rule(const Rule& rule);
+	bool insert_rule(RuleId rule);
 
 	/**
 	 * Set exhausted flag to true
@@ -93,12 +109,24 @@ public:
 	/**
 	 * Set the exhausted flag of that rule to true
 	 */
-	void set_rule_exhausted(const Rule& rule);
+	void set_rule_exhausted(RuleId rule);
 
 	/**
-	 * Check if the given rule has been tried
+	 * Check if the given rule has been tried. npos is never
+	 * exhausted.
 	 */
-	bool is_rule_exhausted(const Rule& rule) const;
+	bool is_rule_exhausted(RuleId rule) const;
+
+	/**
+	 * Return the unifications of the source with the first rules_size
+	 * rules of the chainer rule set. They are cached, and
+	 * unify(from, to) is only called to unify the source with the
+	 * rules at positions [from, to) that have not been considered
+	 * yet, such as new rules produced by meta rules.
+	 */
+	typedef std::function<RuleUnifications(size_t, size_t)> Unifier;
+	RuleUnifications get_unified_rules(size_t rules_size,
+	                                   const Unifier& unify) const;
 
 	/**
 	 * Return the complexity of new source expanded from this source by
@@ -134,12 +162,34 @@ public:
 	// True iff all rules that could expand the source have been tried
 	bool exhausted;
 
-	// Rules so far attempted on that source
-	RuleSet rules;
+	// Ids of the rules so far attempted on that source, and of those
+	// that have been fully applied, sorted. They are usually few, so
+	// sorted vectors are more compact and as fast as hash sets.
+	std::vector<RuleId> rules;
+	std::vector<RuleId> exhausted_rules;
+
+	// Index of the source in its population
+	size_t index;
+
+	// True iff it is one of the initial sources, which are never
+	// evicted from the population
+	bool initial;
+
+	// Number of holders of that source, workers expanding it or work
+	// queues, guarded by the mutex of its population. A source is
+	// only evicted if it has no holder.
+	unsigned holders;
 
 private:
-	// NEXT TODO: subdivide in smaller and shared mutexes
-	mutable std::mutex _mutex;
+	// Return the mutex guarding exhausted, rules, exhausted_rules and
+	// the cache of get_unified_rules. Sources share a fixed set of
+	// mutexes, picked by address, rather than each carrying its own.
+	std::mutex& get_mutex() const;
+
+	// Cache of get_unified_rules, _unified_rules_size is the number of
+	// rules of the rule set the source has been unified with so far.
+	mutable RuleUnifications _unified_rules;
+	mutable size_t _unified_rules_size;
 };
 
 /**
@@ -165,6 +215,12 @@ public:
 	 */
 	void set_exhausted();
 
+	/**
+	 * Set the exhausted flag of the given source, which must belong to
+	 * that population, to true, and update its weight accordingly.
+	 */
+	void set_exhausted(Source& src);
+
 	/**
 	 * When new inference rules come in or we get to retry exhausted
 	 * sources, then reset exhausted flags.
@@ -176,13 +232,69 @@ public:
 	 */
 	bool is_exhausted() const;
 
+	/**
+	 * Sample a source according to its weight in O(log n), and hold
+	 * it, so that it is not evicted till it is released.
+	 *
+	 * Return nullptr if all weights are null, that is if all sources
+	 * are exhausted.
+	 */
+	Source* sample();
+
+	/**
+	 * Release a source previously held by sample or insert.
+	 */
+	void release(Source& src);
+
+	/**
+	 * Release a source upon destruction.
+	 */
+	class ReleaseGuard
+	{
+	public:
+		ReleaseGuard(SourceSet& sources, Source& src);
+		~ReleaseGuard();
+	private:
+		SourceSet& _sources;
+		Source& _src;
+	};
+
 	/**
 	 * Insert produced sources from src into the population, by
 	 * applying rule with a given probability of success prob (useful
 	 * for calculating complexity).
+	 *
+	 * If the population exceeds the maximum source set size, the
+	 * least promising sources are evicted, see evict.
+	 *
+	 * Return the sources that were not already in the population and
+	 * have not been evicted. If hold is true they are held and must
+	 * be released.
 	 */
-	void insert(const HandleSet& products, const Source& src,
-	            double prob, const std::string& msgprfx="");
+	std::vector<Source*> insert(const HandleSet& products, const Source& src,
+	                            double prob, const std::string& msgprfx="",
+	                            bool hold=false);
+
+	/**
+	 * Products of a rule application over a source, with probability
+	 * of success prob.
+	 */
+	struct Production
+	{
+		HandleSet products;
+		const Source* source;
+		double prob;
+	};
+
+	/**
+	 * Like above, but insert the products of multiple rule
+	 * applications at once, under a single lock. A product of
+	 * multiple productions is inserted once, as expanded from the
+	 * source of the first of them.
+	 */
+	std::vector<Source*> insert(const std::vector<Production>& productions,
+	                            const std::string& msgprfx="",
+	                            bool hold=false);
 
 	size_t size() const;
 
@@ -190,10 +302,10 @@ public:
 
 	std::string to_string(const std::string& indent=empty_string) const;
 
-	// Collection of sources. We use a sorted vector instead of a set
-	// because the source being expanded is modified (it keeps track of
-	// its expansion rules). Alternatively we could use a set and
-	// define Sources::rules as mutable.
+	// Collection of sources, so that sources[src.index] is
+	// src. Sources are allocated individually, thus pointers to them
+	// remain valid as the collection grows, and till they are
+	// evicted.
 	typedef boost::ptr_vector<Source> Sources;
 	Sources sources;
 
@@ -201,8 +313,51 @@ public:
 	bool exhausted;
 
 private:
+	// Add new_src to sources and to the sampler. The mutex is assumed
+	// to be locked.
+	void add(Source* new_src);
+
+	// Add the products not already in the population as new sources
+	// expanded from src, and append them to new_srcs. The mutex is
+	// assumed to be locked.
+	void add_products(const HandleSet& products, const Source& src,
+	                  double prob, bool hold, std::vector<Source*>& new_srcs,
+	                  const std::string& msgprfx);
+
+	// Evict sources if needed, remove them from new_srcs and log
+	// them. The mutex is assumed to be locked.
+	void evict_and_log(std::vector<Source*>& new_srcs, size_t products_size,
+	                   const std::string& msgprfx);
+
+	// Remove src from sources, the sampler and the index, and delete
+	// it. The last source takes its place. The mutex is assumed to be
+	// locked.
+	void remove(Source* src);
+
+	// Evict the least promising sources, exhausted first, then of
+	// lowest weight, that are neither initial nor held, so that the
+	// population goes back to 90% of the maximum source set size, if
+	// it exceeds it. Return the evicted sources, which have been
+	// deleted. The mutex is assumed to be locked.
+	std::unordered_set<const Source*> evict(const std::string& msgprfx);
+
 	const UREConfig& _config;
 
+	// Index of the sources by content, for O(1) duplicate detection
+	struct SourceHash
+	{
+		size_t operator()(const Source* src) const;
+	};
+	struct SourceEqual
+	{
+		bool operator()(const Source* ls, const Source* rs) const;
+	};
+	std::unordered_set<const Source*, SourceHash, SourceEqual> _index;
+
+	// Weights of the sources, indexed by Source::index, maintained
+	// incrementally to sample in O(log n).
+	SumTree _sampler;
+
 	// NEXT TODO: subdivide in smaller and shared mutexes
 	mutable std::mutex _mutex;
 };
@@ -63,6 +63,34 @@ class FCTest(TestCase):
         self.assertAlmostEqual(1.0, resultTV.mean, places=5)
         self.assertAlmostEqual(1.0, resultTV.confidence, places=5)
 
+    def test_fc_subscribe(self):
+        self.init()
+        scheme_eval(self.atomspace, '(load-from-path "fc-deduction-config.scm")')
+
+        A = ConceptNode("A")
+        B = ConceptNode("B")
+        C = ConceptNode("C")
+
+        AB = InheritanceLink(A, B)
+        AB.tv = TruthValue(1, 1)
+        InheritanceLink(B, C).tv = TruthValue(1, 1)
+        AC = InheritanceLink(A, C)
+
+        chainer = ForwardChainer(self.atomspace,
+                                 ConceptNode("fc-deduction-rule-base"),
+                                 AB)
+
+        # Record the products as they come, and stop once AC is found
+        products = []
+        def on_product(product):
+            products.append(product)
+            return product != AC
+        chainer.subscribe(on_product)
+        chainer.do_chain()
+
+        self.assertTrue(chainer.is_cancelled())
+        self.assertEqual(AC, products[-1])
+
 
 if __name__ == '__main__':
     os.environ["PROJECT_SOURCE_DIR"] = "../../.."
@@ -0,0 +1,32 @@
+;; Rule base with a single premise rule inverting inheritances. Used
+;; to test that sources of a batch selecting specializations of the
+;; same rule are applied in a single query.
+
+(define inversion-rule
+  (BindLink
+    (VariableList
+      (TypedVariable (Variable "$X") (Type "ConceptNode"))
+      (TypedVariable (Variable "$Y") (Type "ConceptNode"))
+    )
+    (Present
+      (Inheritance
+        (Variable "$X")
+        (Variable "$Y")
+      )
+    )
+    (Inheritance
+      (Variable "$Y")
+      (Variable "$X")
+    )
+  )
+)
+
+(define inversion-rule-name
+  (DefinedSchema "inversion-rule"))
+(Define inversion-rule-name
+  inversion-rule)
+
+(define inversion-rbs (Concept "fc-inversion-rule-base"))
+(ure-add-rules inversion-rbs
+               (list
+                (cons inversion-rule-name (stv 1 1))))
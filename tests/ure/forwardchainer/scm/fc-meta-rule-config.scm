@@ -0,0 +1,48 @@
+;; Rule base with deduction and a meta rule producing, for each
+;; inheritance X->Y, a rule turning the members of X into concepts
+;; similar to Y. Used to test that meta rules are expanded over the
+;; atoms produced during the chaining, such as the inheritances
+;; produced by deduction.
+;;
+;; Requires fc-deduction-config.scm to be loaded.
+
+(define inheritance-to-similarity-meta-rule
+  (BindLink
+    (VariableList
+      (TypedVariable (Variable "$X") (Type "ConceptNode"))
+      (TypedVariable (Variable "$Y") (Type "ConceptNode"))
+    )
+    (Present
+      (Inheritance
+        (Variable "$X")
+        (Variable "$Y")
+      )
+    )
+    (Quote
+      (BindLink
+        (TypedVariable (Variable "$Z") (Type "ConceptNode"))
+        (Present
+          (Member
+            (Variable "$Z")
+            (Unquote (Variable "$X"))
+          )
+        )
+        (Similarity
+          (Variable "$Z")
+          (Unquote (Variable "$Y"))
+        )
+      )
+    )
+  )
+)
+
+(define inheritance-to-similarity-meta-rule-name
+  (DefinedSchema "inheritance-to-similarity-meta-rule"))
+(Define inheritance-to-similarity-meta-rule-name
+  inheritance-to-similarity-meta-rule)
+
+(define meta-rbs (Concept "fc-meta-rule-base"))
+(ure-add-rules meta-rbs
+               (list
+                (cons fc-deduction-rule-name (stv 1 1))
+                (cons inheritance-to-similarity-meta-rule-name (stv 1 1))))
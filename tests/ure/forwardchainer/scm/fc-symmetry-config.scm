@@ -0,0 +1,53 @@
+;; KB and rule base to test that constant clauses, as created by
+;; unifying the source with the rule, must be in the focus set.
+
+(define AB
+  (Inheritance
+    (Concept "A")
+    (Concept "B")
+  )
+)
+
+(define BA
+  (Inheritance
+    (Concept "B")
+    (Concept "A")
+  )
+)
+
+;; Once unified with AB, the other clause becomes the constant BA
+(define symmetry-rule
+  (BindLink
+    (VariableList
+      (Variable "$X")
+      (Variable "$Y")
+    )
+    (And
+      (Present
+        (Inheritance
+          (Variable "$X")
+          (Variable "$Y")
+        )
+        (Inheritance
+          (Variable "$Y")
+          (Variable "$X")
+        )
+      )
+    )
+    (Similarity
+      (Variable "$X")
+      (Variable "$Y")
+    )
+  )
+)
+
+(define symmetry-rule-name
+  (DefinedSchema "symmetry-rule"))
+(Define symmetry-rule-name
+  symmetry-rule)
+
+(define symmetry-rbs (Concept "fc-symmetry-rule-base"))
+(ure-add-rules symmetry-rbs
+               (list
+                (cons symmetry-rule-name (stv 1 1))))
+(ure-set-num-parameter symmetry-rbs "URE:maximum-iterations" 10)